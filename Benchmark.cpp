@@ -0,0 +1,438 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Microbenchmarks of the hot paths on synthetic messages in memory, e.g. for JSON results to track over time:
+// ITCH50_Benchmark --benchmark_out=results.json --benchmark_out_format=json
+
+#include "Generator.h"
+#include "Message.h"
+#include "OrderMap.h"
+#include <benchmark/benchmark.h>
+#include <boost/container/map.hpp>
+#include <charconv>
+#include <map>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ITCH
+{
+
+// A synthetic trading day of about 30 MB, generated once
+const std::string &get_messages()
+{
+  static const auto messages = [] {
+    auto options        = GeneratorOptions{};
+    options.nr_messages = 1'000'000;
+    options.max_orders  = 100'000;
+
+    std::ostringstream output;
+    Generator          generator(options, output);
+    generator.run();
+    return output.str();
+  }();
+
+  return messages;
+}
+
+MessageReader get_reader()
+{
+  return MessageReader{std::span(get_messages())};
+}
+
+std::vector<Message> read_messages(MessageType type = {})
+{
+  auto reader   = get_reader();
+  auto message  = Message{};
+  auto messages = std::vector<Message>{};
+
+  while (reader.next(message))
+  {
+    if (!type || (type == message.get_type()))
+    {
+      messages.push_back(message);
+    }
+  }
+
+  return messages;
+}
+
+std::vector<DecodedMessage> decode_messages()
+{
+  auto decoded = std::vector<DecodedMessage>{};
+
+  for (const auto &message : read_messages())
+  {
+    decoded.push_back(decode(message));
+  }
+
+  return decoded;
+}
+
+void set_bytes_processed(benchmark::State &state)
+{
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * get_messages().size()));
+}
+
+// Message boundaries
+
+void BM_ReaderNext(benchmark::State &state)
+{
+  std::size_t nr_messages{};
+
+  for (auto _ : state)
+  {
+    auto reader  = get_reader();
+    auto message = Message{};
+
+    while (reader.next(message))
+    {
+      ++nr_messages;
+    }
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(nr_messages));
+  set_bytes_processed(state);
+}
+BENCHMARK(BM_ReaderNext);
+
+// Argument 1 skips the message types the handler ignores
+void BM_ReaderNextBlock(benchmark::State &state)
+{
+  std::size_t nr_messages{};
+  auto        block = MessageBlock{};
+
+  for (auto _ : state)
+  {
+    auto reader = get_reader();
+
+    if (state.range(0))
+    {
+      reader.set_type_filter(MessageHandler::TYPE_FILTER);
+    }
+
+    while (reader.next_block(block))
+    {
+      nr_messages += block.size;
+    }
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(nr_messages));
+  set_bytes_processed(state);
+}
+BENCHMARK(BM_ReaderNextBlock)->Arg(0)->Arg(1);
+
+// Decoding
+
+void BM_Decode(benchmark::State &state)
+{
+  const auto messages = read_messages();
+
+  for (auto _ : state)
+  {
+    for (const auto &message : messages)
+    {
+      benchmark::DoNotOptimize(decode(message));
+    }
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * messages.size()));
+}
+BENCHMARK(BM_Decode);
+
+void BM_DecodeBlock(benchmark::State &state)
+{
+  std::size_t nr_messages{};
+  auto        block = MessageBlock{};
+
+  for (auto _ : state)
+  {
+    auto reader = get_reader();
+
+    while (reader.next_block(block))
+    {
+      for (std::size_t i = 0; i < block.size; ++i)
+      {
+        benchmark::DoNotOptimize(block.decode(i));
+      }
+
+      nr_messages += block.size;
+    }
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(nr_messages));
+}
+BENCHMARK(BM_DecodeBlock);
+
+// One accessor on all messages of TYPE, all messages for the header accessors
+template <MessageType TYPE, typename Submessage, auto GET> void BM_Accessor(benchmark::State &state)
+{
+  const auto messages = read_messages(TYPE);
+
+  for (auto _ : state)
+  {
+    for (const auto &message : messages)
+    {
+      benchmark::DoNotOptimize((static_cast<const Submessage &>(message).*GET)());
+    }
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * messages.size()));
+}
+BENCHMARK_TEMPLATE(BM_Accessor, MessageType{}, Message, &Message::get_type);
+BENCHMARK_TEMPLATE(BM_Accessor, MessageType{}, Message, &Message::get_stock_locate);
+BENCHMARK_TEMPLATE(BM_Accessor, MessageType{}, Message, &Message::get_timestamp);
+BENCHMARK_TEMPLATE(BM_Accessor, AddOrder, AddOrderMessage, &AddOrderMessage::get_order_reference_number);
+BENCHMARK_TEMPLATE(BM_Accessor, AddOrder, AddOrderMessage, &AddOrderMessage::get_nr_shares);
+BENCHMARK_TEMPLATE(BM_Accessor, AddOrder, AddOrderMessage, &AddOrderMessage::get_stock);
+BENCHMARK_TEMPLATE(BM_Accessor, AddOrder, AddOrderMessage, &AddOrderMessage::get_price);
+BENCHMARK_TEMPLATE(BM_Accessor, OrderExecuted, OrderExecutedMessage, &OrderExecutedMessage::get_nr_shares);
+BENCHMARK_TEMPLATE(BM_Accessor, OrderExecutedWithPrice, OrderExecutedWithPriceMessage,
+                   &OrderExecutedWithPriceMessage::get_price);
+BENCHMARK_TEMPLATE(BM_Accessor, OrderCancel, OrderCancelMessage, &OrderCancelMessage::get_nr_shares);
+BENCHMARK_TEMPLATE(BM_Accessor, OrderDelete, OrderDeleteMessage, &OrderDeleteMessage::get_order_reference_number);
+BENCHMARK_TEMPLATE(BM_Accessor, OrderReplace, OrderReplaceMessage,
+                   &OrderReplaceMessage::get_new_order_reference_number);
+BENCHMARK_TEMPLATE(BM_Accessor, Trade, TradeMessage, &TradeMessage::get_price);
+
+// Handler branches, each on a book of NR_ORDERS orders added and deleted around it untimed
+
+constexpr std::size_t   NR_ORDERS  = 64 * 1024;
+constexpr StockLocate_t NR_SYMBOLS = 1000;
+
+DecodedMessage make_message(MessageType type, OrderReferenceNumber_t ref, SharesCount_t nr_shares = 0)
+{
+  auto message                   = DecodedMessage{};
+  message.type                   = type;
+  message.timestamp              = 4 * HOUR_IN_NANOS;
+  message.locate                 = static_cast<StockLocate_t>(1 + ref % NR_SYMBOLS);
+  message.order_reference_number = ref;
+  message.nr_shares              = nr_shares;
+  message.price                  = static_cast<Price_t>(100'000 + ref % 1000);
+  message.printable              = Printable::Yes;
+  return message;
+}
+
+// Reports far beyond the messages' timestamps, nothing is written
+ReportOptions get_no_report_options()
+{
+  auto options    = ReportOptions{};
+  options.periods = {24 * HOUR_IN_NANOS};
+  return options;
+}
+
+void process_orders(MessageHandler &handler, MessageType type, OrderReferenceNumber_t first_ref = 1)
+{
+  for (OrderReferenceNumber_t ref = first_ref; ref < first_ref + NR_ORDERS; ++ref)
+  {
+    handler.process(make_message(type, ref, 100));
+  }
+}
+
+template <MessageType TYPE> void BM_Process(benchmark::State &state)
+{
+  auto handler  = MessageHandler{NR_ORDERS, get_no_report_options()};
+  auto messages = std::vector<DecodedMessage>{};
+
+  for (OrderReferenceNumber_t ref = 1; ref <= NR_ORDERS; ++ref)
+  {
+    messages.push_back(make_message(TYPE, ref, 1));
+    messages.back().new_order_reference_number = NR_ORDERS + ref;
+  }
+
+  for (auto _ : state)
+  {
+    if (AddOrder != TYPE)
+    {
+      state.PauseTiming();
+      process_orders(handler, AddOrder);
+      state.ResumeTiming();
+    }
+
+    for (const auto &message : messages)
+    {
+      handler.process(message);
+    }
+
+    state.PauseTiming();
+    process_orders(handler, OrderDelete, (OrderReplace == TYPE) ? NR_ORDERS + 1 : 1);
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * messages.size()));
+}
+BENCHMARK_TEMPLATE(BM_Process, AddOrder);
+BENCHMARK_TEMPLATE(BM_Process, OrderExecuted);
+BENCHMARK_TEMPLATE(BM_Process, OrderExecutedWithPrice);
+BENCHMARK_TEMPLATE(BM_Process, OrderCancel);
+BENCHMARK_TEMPLATE(BM_Process, OrderDelete);
+BENCHMARK_TEMPLATE(BM_Process, OrderReplace);
+BENCHMARK_TEMPLATE(BM_Process, Trade);
+
+// The whole synthetic day through the reader and the handler, without logging the system events
+void BM_HandleBlocks(benchmark::State &state)
+{
+  std::size_t nr_messages{};
+  auto        block  = MessageBlock{};
+  auto        filter = MessageHandler::TYPE_FILTER;
+
+  filter[SystemEvent] = false;
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    auto handler = std::make_unique<MessageHandler>(NR_ORDERS, get_no_report_options());
+    auto reader  = get_reader();
+    reader.set_type_filter(filter);
+    state.ResumeTiming();
+
+    while (reader.next_block(block))
+    {
+      handler->handle_block(block);
+      nr_messages += block.size;
+    }
+
+    state.PauseTiming();
+    handler.reset();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(nr_messages));
+  set_bytes_processed(state);
+}
+BENCHMARK(BM_HandleBlocks)->Unit(benchmark::kMillisecond);
+
+// Order maps replaying the order book updates of the synthetic day
+
+template <typename OrderMap> void BM_OrderMap(benchmark::State &state)
+{
+  const auto messages = decode_messages();
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    auto orders = std::make_unique<OrderMap>();
+    orders->reserve(NR_ORDERS);
+    state.ResumeTiming();
+
+    for (const auto &message : messages)
+    {
+      auto order = OrderInfo{};
+
+      switch (message.type)
+      {
+      case AddOrder:
+      case AddOrderMPIDAttribution:
+        orders->try_emplace(message.order_reference_number, message.locate, message.price, message.nr_shares);
+        break;
+      case OrderExecuted:
+      case OrderExecutedWithPrice:
+      case OrderCancel:
+        benchmark::DoNotOptimize(orders->find(message.order_reference_number));
+        break;
+      case OrderDelete:
+        benchmark::DoNotOptimize(orders->extract(message.order_reference_number, order));
+        break;
+      case OrderReplace:
+        if (orders->extract(message.order_reference_number, order))
+        {
+          orders->try_emplace(message.new_order_reference_number, order.locate, message.price, message.nr_shares);
+        }
+        break;
+      default:
+        break;
+      }
+    }
+
+    state.PauseTiming();
+    orders.reset();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * messages.size()));
+}
+
+using PagedOrders         = PagedOrderMap<OrderReferenceNumber_t, OrderInfo>;
+using HashOrders          = HashOrderMap<OrderReferenceNumber_t, OrderInfo>;
+using SegmentedHashOrders = HashOrderMap<OrderReferenceNumber_t, OrderInfo,
+                                         ankerl::unordered_dense::segmented_map<OrderReferenceNumber_t, OrderInfo>>;
+using StdHashOrders =
+    HashOrderMap<OrderReferenceNumber_t, OrderInfo, std::unordered_map<OrderReferenceNumber_t, OrderInfo>>;
+using StdTreeOrders = HashOrderMap<OrderReferenceNumber_t, OrderInfo, std::map<OrderReferenceNumber_t, OrderInfo>>;
+using BoostTreeOrders =
+    HashOrderMap<OrderReferenceNumber_t, OrderInfo, boost::container::map<OrderReferenceNumber_t, OrderInfo>>;
+using FlatTreeOrders = HashOrderMap<OrderReferenceNumber_t, OrderInfo, TreeMap<OrderReferenceNumber_t, OrderInfo>>;
+
+BENCHMARK_TEMPLATE(BM_OrderMap, PagedOrders)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_OrderMap, HashOrders)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_OrderMap, SegmentedHashOrders)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_OrderMap, StdHashOrders)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_OrderMap, StdTreeOrders)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_OrderMap, BoostTreeOrders)->Unit(benchmark::kMillisecond);
+// Erasing from the middle of a sorted vector, orders of magnitude slower
+BENCHMARK_TEMPLATE(BM_OrderMap, FlatTreeOrders)->Unit(benchmark::kMillisecond);
+
+// Report formatting of a day's worth of stocks, argument is the number of VWAP decimals
+
+void BM_FormatReport(benchmark::State &state)
+{
+  auto options          = ReportOptions{};
+  options.vwap_decimals = static_cast<unsigned>(state.range(0));
+
+  const auto writer = ReportWriter{options};
+  auto       random = Random{1};
+  auto       report = ReportWriter::Report{};
+  auto       buffer = std::string{};
+
+  for (std::size_t i = 0; i < 8000; ++i)
+  {
+    auto bar = Bar{};
+
+    for (int trade = 0; trade < 16; ++trade)
+    {
+      bar.add(static_cast<SharesCount_t>(1 + random.below(10'000)), static_cast<Price_t>(random.below(5'000'000)));
+    }
+
+    auto stock = Stock_t{};
+    stock.fill(' ');
+    std::to_chars(stock.data(), stock.data() + stock.size(), i);
+    report.stocks.emplace_back(stock, bar);
+  }
+
+  for (auto _ : state)
+  {
+    writer.format(report, buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * report.stocks.size()));
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * buffer.size()));
+}
+BENCHMARK(BM_FormatReport)->Arg(4)->Arg(9);
+
+} // namespace ITCH
+
+BENCHMARK_MAIN();
@@ -0,0 +1,54 @@
+# Time windows ending between hourly report boundaries still report their tail and empty windows fail, on a
+# seeded generated file:
+# cmake -DGENERATOR=<ITCH50_Generator> -DANALYZER=<ITCH50_Hourly_VWAP> -DWORK_DIR=<dir> -P CheckTimeWindow.cmake
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+execute_process(COMMAND ${GENERATOR} --seed 7 --messages 200000 --symbols 50 window.itch
+                WORKING_DIRECTORY ${WORK_DIR} RESULT_VARIABLE result)
+
+if (NOT result EQUAL 0)
+  message(FATAL_ERROR "Generating window.itch failed")
+endif()
+
+# <start> <end> <report expected at the end>
+foreach (window "14:10;14:50;Stock_VWAP_1450.csv" "14:00;15:30;Stock_VWAP_1530.csv")
+  list(GET window 0 start)
+  list(GET window 1 end)
+  list(GET window 2 report)
+
+  set(run_dir ${WORK_DIR}/${report})
+  file(MAKE_DIRECTORY ${run_dir})
+
+  execute_process(COMMAND ${ANALYZER} --start ${start} --end ${end} ../window.itch
+                  WORKING_DIRECTORY ${run_dir} RESULT_VARIABLE result OUTPUT_VARIABLE output)
+
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "The ${start}-${end} window failed:\n${output}")
+  endif()
+
+  if (NOT EXISTS ${run_dir}/${report})
+    message(FATAL_ERROR "The ${start}-${end} window wrote no ${report}:\n${output}")
+  endif()
+
+  file(STRINGS ${run_dir}/${report} lines)
+  list(LENGTH lines nr_lines)
+
+  if (nr_lines LESS 2)
+    message(FATAL_ERROR "${report} of the ${start}-${end} window holds no stock")
+  endif()
+endforeach()
+
+# Empty windows, reversed or after the last message, fail rather than report nothing
+foreach (window "14:50;14:10" "21:00;22:00")
+  list(GET window 0 start)
+  list(GET window 1 end)
+
+  execute_process(COMMAND ${ANALYZER} --start ${start} --end ${end} window.itch
+                  WORKING_DIRECTORY ${WORK_DIR} RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+
+  if (result EQUAL 0)
+    message(FATAL_ERROR "The empty ${start}-${end} window succeeded")
+  endif()
+endforeach()
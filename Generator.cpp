@@ -0,0 +1,322 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Generator.h"
+#include <algorithm>
+
+namespace ITCH
+{
+
+std::string Generator::get_symbol(StockLocate_t locate) const
+{
+  // Four letters, AAAA for locate 1
+  std::string symbol(4, 'A');
+
+  for (auto i = symbol.size(), n = static_cast<std::size_t>(locate - 1); (i > 0) && n; n /= 26)
+  {
+    symbol[--i] = static_cast<char>('A' + n % 26);
+  }
+
+  return symbol;
+}
+
+void Generator::system_event(char code)
+{
+  auto *message = m_writer.add<SystemEventLayout>(0, m_timestamp);
+  MessageWriter::put<SystemEventLayout::EventCode>(message, std::string_view{&code, 1});
+}
+
+void Generator::directory()
+{
+  m_prices.resize(m_options.nr_symbols + 1);
+
+  for (std::size_t i = 1; i <= m_options.nr_symbols; ++i)
+  {
+    const auto locate = static_cast<StockLocate_t>(i);
+    const auto symbol = get_symbol(locate);
+    auto      *stock  = m_writer.add<StockDirectoryLayout>(locate, m_timestamp);
+
+    MessageWriter::put<StockDirectoryLayout::Stock>(stock, symbol);
+    MessageWriter::put<StockDirectoryLayout::MarketCategory>(stock, "Q");
+    MessageWriter::put<StockDirectoryLayout::FinancialStatusIndicator>(stock, "N");
+    MessageWriter::put<StockDirectoryLayout::RoundLotSize>(stock, 100);
+    MessageWriter::put<StockDirectoryLayout::RoundLotsOnly>(stock, "N");
+    MessageWriter::put<StockDirectoryLayout::IssueClassification>(stock, "C");
+    MessageWriter::put<StockDirectoryLayout::IssueSubType>(stock, "Z");
+    MessageWriter::put<StockDirectoryLayout::Authenticity>(stock, "P");
+    MessageWriter::put<StockDirectoryLayout::ShortSaleThresholdIndicator>(stock, "N");
+    MessageWriter::put<StockDirectoryLayout::IPOFlag>(stock, "N");
+    MessageWriter::put<StockDirectoryLayout::LULDReferencePriceTier>(stock, "2");
+    MessageWriter::put<StockDirectoryLayout::ETPFlag>(stock, "N");
+    MessageWriter::put<StockDirectoryLayout::InverseIndicator>(stock, "N");
+
+    auto *action = m_writer.add<StockTradingActionLayout>(locate, m_timestamp);
+    MessageWriter::put<StockTradingActionLayout::Stock>(action, symbol);
+    MessageWriter::put<StockTradingActionLayout::TradingState>(action, "T");
+
+    // $1 to $500
+    m_prices[locate] = static_cast<Price_t>((1 + m_random.below(500)) * PRICE_SCALE);
+  }
+}
+
+Action Generator::pick_action()
+{
+  auto weight = m_random.below(m_total_weight);
+  auto index  = std::size_t{};
+
+  while (weight >= m_options.mix[index])
+  {
+    weight -= m_options.mix[index++];
+  }
+
+  const auto action = static_cast<Action>(index);
+
+  // Keeps the number of live orders between 1 and max_orders
+  if ((Action::Add == action) && (m_orders.size() >= m_options.max_orders))
+  {
+    return Action::Delete;
+  }
+
+  if ((Action::Add != action) && (Action::Trade != action) && m_orders.empty())
+  {
+    return Action::Add;
+  }
+
+  return action;
+}
+
+std::size_t Generator::pick_order()
+{
+  const auto nr_orders = m_orders.size();
+
+  // Orders are mostly updated shortly after they were added, the most recent ones are at the end
+  if (m_random.percent(m_options.locality))
+  {
+    const auto nr_recent = std::min(nr_orders, RECENT_ORDERS);
+    return nr_orders - 1 - m_random.below(nr_recent);
+  }
+
+  return m_random.below(nr_orders);
+}
+
+void Generator::remove_order(std::size_t index)
+{
+  m_orders[index] = m_orders.back();
+  m_orders.pop_back();
+}
+
+void Generator::add()
+{
+  auto order   = Order{};
+  order.locate = static_cast<StockLocate_t>(1 + m_random.below(m_options.nr_symbols));
+  order.side   = m_random.percent(50) ? 'B' : 'S';
+  order.shares = static_cast<SharesCount_t>(m_random.percent(80) ? 100 * (1 + m_random.below(10))
+                                                                 : 1 + m_random.below(5000));
+  m_next_ref  += 1 + m_random.below(m_options.ref_gap);
+  order.ref    = m_next_ref;
+
+  // Within 1% of the stock's reference price, which follows the orders
+  auto &reference = m_prices[order.locate];
+  order.price     = static_cast<Price_t>(reference - reference / 100 + m_random.below(reference / 50 + 1));
+  reference       = std::max<Price_t>(order.price, PRICE_SCALE / 100);
+
+  const auto mpid    = m_random.percent(10);
+  auto      *message = mpid ? m_writer.add<AddOrderMPIDAttributionLayout>(order.locate, m_timestamp)
+                            : m_writer.add<AddOrderLayout>(order.locate, m_timestamp);
+
+  MessageWriter::put<AddOrderLayout::OrderReferenceNumber>(message, order.ref);
+  MessageWriter::put<AddOrderLayout::BuySellIndicator>(message, std::string_view{&order.side, 1});
+  MessageWriter::put<AddOrderLayout::Shares>(message, order.shares);
+  MessageWriter::put<AddOrderLayout::Stock>(message, get_symbol(order.locate));
+  MessageWriter::put<AddOrderLayout::Price>(message, order.price);
+
+  if (mpid)
+  {
+    MessageWriter::put<AddOrderMPIDAttributionLayout::Attribution>(message, "GNRT");
+  }
+
+  m_orders.push_back(order);
+}
+
+void Generator::execute()
+{
+  const auto index    = pick_order();
+  auto      &order    = m_orders[index];
+  const auto executed = static_cast<SharesCount_t>(m_random.percent(50) ? order.shares
+                                                                        : 1 + m_random.below(order.shares));
+
+  if (m_random.percent(20))
+  {
+    // Executed at a price other than the order's, not always printable
+    const auto printable = m_random.percent(80) ? "Y" : "N";
+    auto      *message   = m_writer.add<OrderExecutedWithPriceLayout>(order.locate, m_timestamp);
+
+    MessageWriter::put<OrderExecutedWithPriceLayout::OrderReferenceNumber>(message, order.ref);
+    MessageWriter::put<OrderExecutedWithPriceLayout::ExecutedShares>(message, executed);
+    MessageWriter::put<OrderExecutedWithPriceLayout::MatchNumber>(message, ++m_next_match);
+    MessageWriter::put<OrderExecutedWithPriceLayout::Printable>(message, printable);
+    MessageWriter::put<OrderExecutedWithPriceLayout::ExecutionPrice>(message, order.price - order.price / 1000);
+  }
+  else
+  {
+    auto *message = m_writer.add<OrderExecutedLayout>(order.locate, m_timestamp);
+
+    MessageWriter::put<OrderExecutedLayout::OrderReferenceNumber>(message, order.ref);
+    MessageWriter::put<OrderExecutedLayout::ExecutedShares>(message, executed);
+    MessageWriter::put<OrderExecutedLayout::MatchNumber>(message, ++m_next_match);
+  }
+
+  order.shares -= executed;
+
+  if (0 == order.shares)
+  {
+    remove_order(index);
+  }
+}
+
+void Generator::cancel()
+{
+  const auto index = pick_order();
+  auto      &order = m_orders[index];
+
+  // Partial only, a full cancel is a delete
+  if (order.shares < 2)
+  {
+    remove();
+    return;
+  }
+
+  const auto cancelled = static_cast<SharesCount_t>(1 + m_random.below(order.shares - 1));
+  auto      *message   = m_writer.add<OrderCancelLayout>(order.locate, m_timestamp);
+
+  MessageWriter::put<OrderCancelLayout::OrderReferenceNumber>(message, order.ref);
+  MessageWriter::put<OrderCancelLayout::CancelledShares>(message, cancelled);
+  order.shares -= cancelled;
+}
+
+void Generator::remove()
+{
+  const auto index   = pick_order();
+  auto      *message = m_writer.add<OrderDeleteLayout>(m_orders[index].locate, m_timestamp);
+
+  MessageWriter::put<OrderDeleteLayout::OrderReferenceNumber>(message, m_orders[index].ref);
+  remove_order(index);
+}
+
+void Generator::replace()
+{
+  const auto index   = pick_order();
+  auto      &order   = m_orders[index];
+  auto      *message = m_writer.add<OrderReplaceLayout>(order.locate, m_timestamp);
+
+  // The replacement keeps the stock and side and moves to the end as the most recent order
+  m_next_ref   += 1 + m_random.below(m_options.ref_gap);
+  order.shares  = static_cast<SharesCount_t>(100 * (1 + m_random.below(10)));
+  order.price  += static_cast<Price_t>(m_random.below(order.price / 100 + 1));
+  order.price  -= static_cast<Price_t>(m_random.below(order.price / 100 + 1));
+  order.price   = std::max<Price_t>(order.price, 1);
+
+  MessageWriter::put<OrderReplaceLayout::OriginalOrderReferenceNumber>(message, order.ref);
+  MessageWriter::put<OrderReplaceLayout::NewOrderReferenceNumber>(message, m_next_ref);
+  MessageWriter::put<OrderReplaceLayout::Shares>(message, order.shares);
+  MessageWriter::put<OrderReplaceLayout::Price>(message, order.price);
+
+  order.ref = m_next_ref;
+  std::swap(order, m_orders.back());
+}
+
+void Generator::trade()
+{
+  // Execution of a non-displayed order, which has no add message
+  const auto locate  = static_cast<StockLocate_t>(1 + m_random.below(m_options.nr_symbols));
+  auto      *message = m_writer.add<TradeLayout>(locate, m_timestamp);
+
+  MessageWriter::put<TradeLayout::OrderReferenceNumber>(message, 0);
+  MessageWriter::put<TradeLayout::BuySellIndicator>(message, "B");
+  MessageWriter::put<TradeLayout::Shares>(message, 100 * (1 + m_random.below(10)));
+  MessageWriter::put<TradeLayout::Stock>(message, get_symbol(locate));
+  MessageWriter::put<TradeLayout::Price>(message, m_prices[locate]);
+  MessageWriter::put<TradeLayout::MatchNumber>(message, ++m_next_match);
+}
+
+void Generator::run()
+{
+  system_event(EVENT_CODES[m_next_event++]);
+  directory();
+  m_timestamp = OPEN_TIME;
+  system_event(EVENT_CODES[m_next_event++]);
+
+  const auto nr_messages = m_writer.get_nr_messages();
+
+  while (m_writer.get_nr_messages() < nr_messages + m_options.nr_messages)
+  {
+    const auto timestamp = m_timestamp + m_random.below(2 * m_mean_interval + 1);
+
+    // A rate too low for the messages ends the orders with system hours
+    if (timestamp >= CLOSE_TIME)
+    {
+      break;
+    }
+
+    m_timestamp = timestamp;
+
+    // Market open and market close, end of system hours is written after all orders
+    while ((m_next_event < std::size(EVENT_TIMES)) && (m_timestamp >= EVENT_TIMES[m_next_event]))
+    {
+      system_event(EVENT_CODES[m_next_event++]);
+    }
+
+    switch (pick_action())
+    {
+    case Action::Add:
+      add();
+      break;
+    case Action::Execute:
+      execute();
+      break;
+    case Action::Cancel:
+      cancel();
+      break;
+    case Action::Delete:
+      remove();
+      break;
+    case Action::Replace:
+      replace();
+      break;
+    case Action::Trade:
+      trade();
+      break;
+    }
+  }
+
+  // The events not reached yet at their times, end of messages right after the end of system hours
+  for (; m_next_event < std::size(EVENT_CODES) - 1; ++m_next_event)
+  {
+    m_timestamp = std::max(m_timestamp, EVENT_TIMES[std::min(m_next_event, std::size(EVENT_TIMES) - 1)]);
+    system_event(EVENT_CODES[m_next_event]);
+  }
+
+  m_writer.flush();
+}
+
+} // namespace ITCH
@@ -0,0 +1,260 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Message.h"
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ITCH
+{
+
+// SplitMix64, the standard distributions are implementation defined and would make the output platform dependent
+class Random
+{
+public:
+  explicit Random(std::uint64_t seed) : m_state(seed)
+  {
+  }
+
+  std::uint64_t next()
+  {
+    auto z = (m_state += 0x9E3779B97F4A7C15);
+    z      = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z      = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+  }
+
+  // Uniform in [0, bound) for any bound, the high word of the 128-bit product of 64 random bits and bound
+  std::uint64_t below(std::uint64_t bound)
+  {
+    const auto value = next();
+
+#ifdef COMPILER_SUPPORTS_INT128
+    return static_cast<std::uint64_t>((static_cast<unsigned __int128>(value) * bound) >> 64);
+#else
+    // The same product from 32-bit halves, so the output doesn't depend on the compiler
+    constexpr std::uint64_t low_mask = 0xFFFFFFFF;
+
+    const auto low_low   = (value & low_mask) * (bound & low_mask);
+    const auto low_high  = (value & low_mask) * (bound >> 32);
+    const auto high_low  = (value >> 32) * (bound & low_mask);
+    const auto high_high = (value >> 32) * (bound >> 32);
+    const auto middle    = (low_low >> 32) + (low_high & low_mask) + high_low;
+
+    return high_high + (low_high >> 32) + (middle >> 32);
+#endif
+  }
+
+  bool percent(std::uint64_t chance)
+  {
+    return below(100) < chance;
+  }
+
+private:
+  std::uint64_t m_state;
+};
+
+// Buffers length prefixed messages and writes them in large chunks, the last ones by flush()
+class MessageWriter
+{
+public:
+  explicit MessageWriter(std::ostream &output) : m_output(output), m_buffer(1024 * 1024)
+  {
+  }
+
+  // Appends a message of Layout with its header and zeroed fields, to be filled in with put()
+  template <typename Layout> char *add(StockLocate_t locate, Timestamp_t timestamp)
+  {
+    if (m_buffer.size() - m_size < 2 + Layout::LENGTH)
+    {
+      flush();
+    }
+
+    auto *message = m_buffer.data() + m_size + 2;
+
+    m_buffer[m_size]     = static_cast<char>(Layout::LENGTH >> 8);
+    m_buffer[m_size + 1] = static_cast<char>(Layout::LENGTH);
+    std::fill(message, message + Layout::LENGTH, 0);
+    m_size += 2 + Layout::LENGTH;
+
+    put<HeaderLayout::Type>(message, std::string_view{&Layout::TYPE, 1});
+    put<HeaderLayout::StockLocate>(message, locate);
+    put<HeaderLayout::Timestamp>(message, timestamp);
+    ++m_nr_messages;
+    return message;
+  }
+
+  template <typename F> static void put(char *message, std::uint64_t value)
+  {
+    static_assert(!F::ALPHA);
+
+    for (std::size_t i = 0; i < F::SIZE; ++i)
+    {
+      message[F::OFFSET + i] = static_cast<char>(value >> (8 * (F::SIZE - 1 - i)));
+    }
+  }
+
+  template <typename F> static void put(char *message, std::string_view value)
+  {
+    static_assert(F::ALPHA);
+
+    for (std::size_t i = 0; i < F::SIZE; ++i)
+    {
+      message[F::OFFSET + i] = (i < value.size()) ? value[i] : ' ';
+    }
+  }
+
+  void flush()
+  {
+    if (!m_output.write(m_buffer.data(), static_cast<std::streamsize>(m_size)))
+    {
+      throw "Could not write the generated messages!";
+    }
+
+    m_bytes_written += m_size;
+    m_size = 0;
+  }
+
+  std::uint64_t get_nr_messages() const
+  {
+    return m_nr_messages;
+  }
+
+  std::uint64_t get_bytes_written() const
+  {
+    return m_bytes_written;
+  }
+
+private:
+  std::ostream     &m_output;
+  std::vector<char> m_buffer;
+  std::size_t       m_size{};
+  std::uint64_t     m_nr_messages{};
+  std::uint64_t     m_bytes_written{};
+};
+
+enum class Action : std::size_t
+{
+  Add,
+  Execute,
+  Cancel,
+  Delete,
+  Replace,
+  Trade
+};
+
+constexpr std::size_t NR_ACTIONS = 6;
+
+struct GeneratorOptions
+{
+  std::uint64_t seed{1};
+  std::uint64_t nr_messages{10'000'000}; // From the start of system hours to the last order, system events included
+  std::uint64_t nr_symbols{1000};
+  std::uint64_t rate{}; // Messages per second of market time, 0 spreads the messages over the trading day. Orders
+                        // stop at the end of system hours, fewer messages are written when the rate is too low.
+  std::uint64_t max_orders{4'000'000};
+  std::uint64_t ref_gap{4};    // Order reference numbers grow by 1 to ref_gap
+  std::uint64_t locality{50};  // Percentage of order updates on one of the most recent orders
+  std::array<std::uint64_t, NR_ACTIONS> mix{45, 4, 2, 40, 8, 1}; // Weights of add, execute, cancel, delete,
+                                                                 // replace and trade messages
+};
+
+// Synthetic NASDAQ TotalView-ITCH 5.0 messages, the same for the same options on every platform
+class Generator
+{
+public:
+  Generator(const GeneratorOptions &options, std::ostream &output)
+    : m_options(options), m_random(options.seed), m_writer(output)
+  {
+    for (const auto weight : m_options.mix)
+    {
+      m_total_weight += weight;
+    }
+
+    const auto day_length = CLOSE_TIME - OPEN_TIME;
+    m_mean_interval       = m_options.rate ? SEC_IN_NANOS / m_options.rate
+                                           : day_length / std::max<std::uint64_t>(m_options.nr_messages, 1);
+  }
+
+  // Writes the whole trading day
+  void run();
+
+  const MessageWriter &get_writer() const
+  {
+    return m_writer;
+  }
+
+private:
+  struct Order
+  {
+    OrderReferenceNumber_t ref{};
+    Price_t                price{};
+    SharesCount_t          shares{};
+    StockLocate_t          locate{};
+    char                   side{};
+  };
+
+  static constexpr Timestamp_t START_TIME     = 3 * HOUR_IN_NANOS;
+  static constexpr Timestamp_t OPEN_TIME      = 4 * HOUR_IN_NANOS;
+  static constexpr Timestamp_t MARKET_OPEN    = 9 * HOUR_IN_NANOS + 30 * MIN_IN_NANOS;
+  static constexpr Timestamp_t MARKET_CLOSE   = 16 * HOUR_IN_NANOS;
+  static constexpr Timestamp_t CLOSE_TIME     = 20 * HOUR_IN_NANOS;
+  static constexpr std::size_t RECENT_ORDERS  = 4096;
+  static constexpr Price_t     PRICE_SCALE    = 10'000;
+  static constexpr char        EVENT_CODES[]  = "OSQMEC";
+  static constexpr Timestamp_t EVENT_TIMES[]  = {START_TIME, OPEN_TIME, MARKET_OPEN, MARKET_CLOSE, CLOSE_TIME};
+
+  std::string get_symbol(StockLocate_t locate) const;
+  void        system_event(char code);
+  void        directory();
+  Action      pick_action();
+  std::size_t pick_order();
+  void        remove_order(std::size_t index);
+
+  void add();
+  void execute();
+  void cancel();
+  void remove();
+  void replace();
+  void trade();
+
+  const GeneratorOptions &m_options;
+  Random                  m_random;
+  MessageWriter           m_writer;
+  std::uint64_t           m_total_weight{};
+  Timestamp_t             m_mean_interval{};
+  Timestamp_t             m_timestamp{START_TIME};
+  std::size_t             m_next_event{};
+  OrderReferenceNumber_t  m_next_ref{};
+  MatchNumber_t           m_next_match{};
+  std::vector<Order>      m_orders; // Live orders, removed by moving the last one in their place
+  std::vector<Price_t>    m_prices; // Reference price by locate
+};
+
+} // namespace ITCH
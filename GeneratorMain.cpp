@@ -0,0 +1,213 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Generator.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+
+struct Options
+{
+  std::string            filename;
+  ITCH::GeneratorOptions generator;
+};
+
+void print_usage()
+{
+  std::cout << "Usage:" << std::endl
+            << "\tITCH50_Generator [options] <output file>" << std::endl
+            << "\tExample: ITCH50_Generator --messages 400000000 synthetic.NASDAQ_ITCH50" << std::endl
+            << "Options:" << std::endl
+            << "\t--seed <N>\tRandom seed, 1 by default" << std::endl
+            << "\t--messages <N>\tNumber of messages after the start of system hours up to the last order message,"
+            << std::endl
+            << "\t\t\tsystem events in between included, 10000000 by default" << std::endl
+            << "\t--symbols <N>\tNumber of stocks, 1000 by default" << std::endl
+            << "\t--rate <N>\tMessages per second of market time, by default spread over 04:00-20:00, orders stop"
+            << std::endl
+            << "\t\t\tat 20:00 when fewer than --messages fit" << std::endl
+            << "\t--max-orders <N>" << std::endl
+            << "\t\t\tMaximum number of live orders, 4000000 by default" << std::endl
+            << "\t--ref-gap <N>\tOrder reference numbers increase by 1 to N, 4 by default" << std::endl
+            << "\t--locality <N>\tPercentage of order updates on one of the 4096 most recent orders, 50 by default"
+            << std::endl
+            << "\t--mix <add,execute,cancel,delete,replace,trade>" << std::endl
+            << "\t\t\tRelative weights of the order messages, 45,4,2,40,8,1 by default" << std::endl;
+}
+
+bool parse_number(std::string_view arg, std::uint64_t &value)
+{
+  const auto [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+  return (std::errc{} == error) && (arg.data() + arg.size() == end);
+}
+
+bool parse_mix(std::string_view arg, std::array<std::uint64_t, ITCH::NR_ACTIONS> &mix)
+{
+  // Comma separated weights, one per action, adds first
+  std::uint64_t total{};
+
+  for (auto &weight : mix)
+  {
+    const auto field = arg.substr(0, arg.find(','));
+
+    if (!parse_number(field, weight))
+    {
+      return false;
+    }
+
+    total += weight;
+    arg.remove_prefix(std::min(arg.size(), field.size() + 1));
+  }
+
+  return arg.empty() && (0 != total) && (0 != mix.front());
+}
+
+bool parse_options(int argc, char *argv[], Options &options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const auto arg = std::string_view(argv[i]);
+
+    const auto parse_value = [&](std::uint64_t &value, std::uint64_t min, std::uint64_t max) {
+      if ((++i == argc) || !parse_number(argv[i], value) || (value < min) || (value > max))
+      {
+        std::cerr << arg << " expects a number from " << min << " to " << max << std::endl;
+        return false;
+      }
+
+      return true;
+    };
+
+    if ("--seed" == arg)
+    {
+      if (!parse_value(options.generator.seed, 0, std::numeric_limits<std::uint64_t>::max()))
+      {
+        return false;
+      }
+    }
+    else if ("--messages" == arg)
+    {
+      if (!parse_value(options.generator.nr_messages, 1, std::numeric_limits<std::uint64_t>::max()))
+      {
+        return false;
+      }
+    }
+    else if ("--symbols" == arg)
+    {
+      if (!parse_value(options.generator.nr_symbols, 1, ITCH::NR_STOCK_LOCATES - 1))
+      {
+        return false;
+      }
+    }
+    else if ("--rate" == arg)
+    {
+      if (!parse_value(options.generator.rate, 1, ITCH::SEC_IN_NANOS))
+      {
+        return false;
+      }
+    }
+    else if ("--max-orders" == arg)
+    {
+      if (!parse_value(options.generator.max_orders, 1, std::numeric_limits<std::uint32_t>::max()))
+      {
+        return false;
+      }
+    }
+    else if ("--ref-gap" == arg)
+    {
+      if (!parse_value(options.generator.ref_gap, 1, std::numeric_limits<std::uint32_t>::max()))
+      {
+        return false;
+      }
+    }
+    else if ("--locality" == arg)
+    {
+      if (!parse_value(options.generator.locality, 0, 100))
+      {
+        return false;
+      }
+    }
+    else if ("--mix" == arg)
+    {
+      if ((++i == argc) || !parse_mix(argv[i], options.generator.mix))
+      {
+        std::cerr << "--mix expects 6 comma separated weights, a nonzero add weight" << std::endl;
+        return false;
+      }
+    }
+    else if (arg.starts_with("--") || !options.filename.empty())
+    {
+      std::cerr << "Unexpected argument: " << arg << std::endl;
+      return false;
+    }
+    else
+    {
+      options.filename = arg;
+    }
+  }
+
+  return !options.filename.empty();
+}
+
+int main(int argc, char *argv[])
+{
+  auto options = Options{};
+
+  if (!parse_options(argc, argv, options))
+  {
+    print_usage();
+    return -1;
+  }
+
+  try
+  {
+    auto output = std::ofstream{options.filename, std::ios::binary};
+
+    if (!output)
+    {
+      throw "Could not open the output file!";
+    }
+
+    auto generator = ITCH::Generator{options.generator, output};
+    generator.run();
+
+    std::cout << "Wrote " << generator.get_writer().get_nr_messages() << " messages, "
+              << generator.get_writer().get_bytes_written() << " bytes to " << options.filename << std::endl;
+  }
+  catch (const char *error)
+  {
+    std::cerr << "An error occurred: " << error << std::endl;
+    return -1;
+  }
+  catch (const std::exception &ex)
+  {
+    std::cerr << "An exception occurred: " << ex.what() << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
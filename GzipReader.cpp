@@ -0,0 +1,160 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "GzipReader.h"
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/iostreams/read.hpp>
+
+namespace ITCH
+{
+
+// zlib inflates into the chain in chunks of this size, larger than boost's 4K default to cut per-call overhead
+constexpr std::streamsize GZIP_CHUNK_SIZE = 1024 * 1024;
+
+GzipReader::GzipReader(const std::string &filename, std::size_t prefix_size, std::size_t buffer_size,
+                       std::size_t nr_buffers)
+  : m_buffer_size(buffer_size), m_buffers(nr_buffers)
+{
+  for (auto &buffer : m_buffers)
+  {
+    buffer.storage.reset(new unsigned char[prefix_size + buffer_size]);
+    buffer.data = buffer.storage.get() + prefix_size;
+    m_free.push_back(&buffer);
+  }
+
+  // Fail early on the calling thread instead of inside the decompressor
+  boost::iostreams::file_source file(filename, std::ios::in | std::ios::binary);
+
+  if (!file.is_open())
+  {
+    throw "Failed to open file!";
+  }
+
+  m_thread = std::thread([this, filename] { decompress(filename); });
+}
+
+GzipReader::~GzipReader()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_stop = true;
+  }
+
+  m_cv.notify_all();
+  m_thread.join();
+}
+
+GzipBuffer *GzipReader::acquire()
+{
+  std::unique_lock lock(m_mutex);
+  m_cv.wait(lock, [this] { return !m_filled.empty() || m_done; });
+
+  if (!m_filled.empty())
+  {
+    auto *buffer = m_filled.front();
+    m_filled.pop_front();
+    return buffer;
+  }
+
+  if (m_error)
+  {
+    std::rethrow_exception(m_error);
+  }
+
+  return nullptr;
+}
+
+void GzipReader::release(GzipBuffer *buffer)
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_free.push_back(buffer);
+  }
+
+  m_cv.notify_all();
+}
+
+void GzipReader::decompress(const std::string &filename)
+{
+  try
+  {
+    boost::iostreams::filtering_istreambuf in;
+    in.push(boost::iostreams::gzip_decompressor(boost::iostreams::gzip::default_window_bits, GZIP_CHUNK_SIZE));
+    in.push(boost::iostreams::file_source(filename, std::ios::in | std::ios::binary), GZIP_CHUNK_SIZE);
+
+    for (bool eof = false; !eof;)
+    {
+      GzipBuffer *buffer{};
+
+      {
+        std::unique_lock lock(m_mutex);
+        m_cv.wait(lock, [this] { return !m_free.empty() || m_stop; });
+
+        if (m_stop)
+        {
+          return;
+        }
+
+        buffer = m_free.front();
+        m_free.pop_front();
+      }
+
+      buffer->size = 0;
+
+      while (buffer->size < m_buffer_size)
+      {
+        const auto nr_read = boost::iostreams::read(in, reinterpret_cast<char *>(buffer->data) + buffer->size,
+                                                    m_buffer_size - buffer->size);
+        if (nr_read < 0)
+        {
+          eof = true;
+          break;
+        }
+
+        buffer->size += nr_read;
+      }
+
+      {
+        std::lock_guard lock(m_mutex);
+        (buffer->size ? m_filled : m_free).push_back(buffer);
+      }
+
+      m_cv.notify_all();
+    }
+  }
+  catch (...)
+  {
+    std::lock_guard lock(m_mutex);
+    m_error = std::current_exception();
+  }
+
+  {
+    std::lock_guard lock(m_mutex);
+    m_done = true;
+  }
+
+  m_cv.notify_all();
+}
+
+} // namespace ITCH
@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ITCH
+{
+
+struct GzipBuffer
+{
+  std::unique_ptr<unsigned char[]> storage;
+  unsigned char                   *data{}; // Start of the decompressed bytes, right after the prefix
+  std::size_t                      size{}; // Number of decompressed bytes
+};
+
+// Decompresses a gzip file on a background thread into a ring of large buffers.
+// Every buffer reserves `prefix_size` bytes in front of the decompressed data, so the consumer can move the
+// unconsumed tail of the previous buffer (a message straddling the boundary) in front of the new data.
+class GzipReader
+{
+public:
+  GzipReader(const std::string &filename, std::size_t prefix_size, std::size_t buffer_size = 64 * 1024 * 1024,
+             std::size_t nr_buffers = 4);
+  ~GzipReader();
+
+  GzipReader(const GzipReader &)            = delete;
+  GzipReader &operator=(const GzipReader &) = delete;
+
+  // Blocks until the next decompressed buffer is available, nullptr at the end of the stream
+  GzipBuffer *acquire();
+  // Hands a buffer back to the decompressing thread
+  void release(GzipBuffer *buffer);
+
+private:
+  void decompress(const std::string &filename);
+
+  const std::size_t        m_buffer_size;
+  std::vector<GzipBuffer>  m_buffers;
+  std::deque<GzipBuffer *> m_free;
+  std::deque<GzipBuffer *> m_filled;
+  std::mutex               m_mutex;
+  std::condition_variable  m_cv;
+  std::exception_ptr       m_error;
+  bool                     m_done{};
+  bool                     m_stop{};
+  std::thread              m_thread;
+};
+
+} // namespace ITCH
@@ -21,11 +21,23 @@
 // SOFTWARE.
 //
 #include "Message.h"
+#include "GzipReader.h"
+#include "PerfCounters.h"
+#include "Progress.h"
+#include "Stats.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
 
+#if COMPILER_SUPPORTS_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
 inline void try_prefetch(const void *addr)
 {
 #if COMPILER_SUPPORTS_BUILTIN_PREFETCH
@@ -46,13 +58,10 @@ inline void try_prefetch(const void *addr)
 namespace ITCH
 {
 
-constexpr Timestamp_t SEC_IN_NANOS  = 1'000'000'000;
-constexpr Timestamp_t MIN_IN_NANOS  = 60 * SEC_IN_NANOS;
-constexpr Timestamp_t HOUR_IN_NANOS = 60 * MIN_IN_NANOS;
-
-constexpr auto REPORT_PERIOD           = HOUR_IN_NANOS;
-constexpr auto PRICE_CONVERSION_FACTOR = 1.0 / 10'000;
-constexpr auto MESSAGE_LENGTH_SIZE     = 2u;
+constexpr auto PRICE_SCALE             = 10'000u; // Price(4)
+constexpr auto PRICE_DECIMALS          = 4u;
+constexpr auto MAX_MESSAGE_SIZE        = MESSAGE_LENGTH_SIZE + 0xFFFFu;
+constexpr auto HEADER_LOAD_SIZE        = 16u; // Bytes loaded per message by the vector header decoders
 
 // Wraps Timestamp_t just for operator<<(ostream&)
 struct Timestamp
@@ -82,342 +91,995 @@ inline std::ostream &operator<<(std::ostream &ss, const Timestamp &timestamp)
   return ss;
 }
 
-inline std::string_view read_string(const unsigned char *bytes, std::size_t length)
+constexpr std::uint64_t pow10(unsigned exponent)
 {
-  return std::string_view(reinterpret_cast<const char *>(bytes), length);
+  return exponent ? 10 * pow10(exponent - 1) : 1;
 }
 
-inline std::uint8_t read_1(const unsigned char *bytes)
+// Appends integer_part.fractional_part, zero padded to decimals, first must have room for 20 + 1 + decimals characters
+char *format_decimal(char *first, std::uint64_t integer_part, std::uint64_t fractional_part, unsigned decimals)
 {
-  return bytes[0];
+  first = std::to_chars(first, first + 20, integer_part).ptr;
+
+  if (0 == decimals)
+  {
+    return first;
+  }
+
+  *first++ = '.';
+
+  for (auto *digit = first + decimals; digit != first; fractional_part /= 10)
+  {
+    *--digit = static_cast<char>('0' + fractional_part % 10);
+  }
+
+  return first + decimals;
 }
 
-inline std::uint16_t read_2(const unsigned char *bytes)
+// Appends the exact VWAP, rounded half up to decimals
+char *format_vwap(char *first, const Bar &bar, unsigned decimals)
 {
-  return (std::uint16_t)bytes[1] | (std::uint16_t)(bytes[0] << 8);
+  const auto decimal_scale = pow10(decimals);
+
+  std::uint64_t integer_part{};
+  std::uint64_t fractional_part{};
+
+  if (0 != bar.volume)
+  {
+    const auto denominator = Notional_t{bar.volume} * PRICE_SCALE;
+    auto       remainder   = bar.notional % denominator;
+    integer_part           = static_cast<std::uint64_t>(bar.notional / denominator);
+
+    // Long division one digit at a time, so the remainder cannot overflow whatever the precision
+    for (unsigned i = 0; i < decimals; ++i)
+    {
+      remainder *= 10;
+      fractional_part = fractional_part * 10 + static_cast<std::uint64_t>(remainder / denominator);
+      remainder %= denominator;
+    }
+
+    if (remainder >= denominator - remainder)
+    {
+      ++fractional_part;
+    }
+
+    if (decimal_scale == fractional_part)
+    {
+      ++integer_part;
+      fractional_part = 0;
+    }
+  }
+
+  return format_decimal(first, integer_part, fractional_part, decimals);
 }
 
-inline std::uint32_t read_4(const unsigned char *bytes)
+char *format_price(char *first, Price_t price)
 {
-  return (std::uint32_t)bytes[3] | (std::uint32_t)(bytes[2] << 8) | (std::uint32_t)(bytes[1] << 16) |
-         (std::uint32_t)(bytes[0] << 24);
+  return format_decimal(first, price / PRICE_SCALE, price % PRICE_SCALE, PRICE_DECIMALS);
 }
 
-inline std::uint64_t read_6(const unsigned char *bytes)
+template <typename T> void write_binary(std::ostream &os, const T &value)
 {
-  const std::uint64_t upper = read_2(bytes);
-  const std::uint64_t lower = read_4(bytes + 2);
-  return lower | (upper << 32);
+  os.write(reinterpret_cast<const char *>(&value), sizeof(value));
 }
 
-inline std::uint64_t read_8(const unsigned char *bytes)
+template <typename T> T read_binary(std::istream &is)
 {
-  const std::uint64_t upper = read_4(bytes);
-  const std::uint64_t lower = read_4(bytes + 4);
-  return lower | (upper << 32);
+  T value{};
+
+  if (!is.read(reinterpret_cast<char *>(&value), sizeof(value)))
+  {
+    throw "Truncated snapshot!";
+  }
+
+  return value;
 }
 
-std::size_t Message::get_offset() const
+MessageReader::MessageReader(std::string filename)
 {
-  return m_pos;
+  if (filename.ends_with(".gz"))
+  {
+    // Room in front of each buffer for the unconsumed tail of the previous one, at most a partial message
+    m_gzip = std::make_unique<GzipReader>(filename, MAX_MESSAGE_SIZE);
+    return;
+  }
+
+  m_file.open(filename, boost::iostreams::mapped_file::readonly);
+  m_data = (const unsigned char *)(m_file.const_data());
+  m_size = m_file.size();
+
+  if (!m_file.is_open() || !m_data || (0 == m_size))
+  {
+    throw "Failed to open file!";
+  }
 }
 
-std::size_t Message::get_length() const
+MessageReader::MessageReader(const MessageReader &reader, std::size_t begin, std::size_t end)
+  : m_file(reader.m_file), m_pos(begin), m_data(reader.m_data), m_size(std::min(end, reader.m_size)),
+    m_wanted_types(reader.m_wanted_types), m_progress(reader.m_progress), m_published_pos(begin)
 {
-  return m_raw_data.size();
+  if (!reader.is_mapped())
+  {
+    throw "Only memory mapped files can be split!";
+  }
 }
 
-MessageType Message::get_type() const
+MessageReader::MessageReader(std::span<const char> data)
+  : m_data(reinterpret_cast<const unsigned char *>(data.data())), m_size(data.size())
 {
-  return static_cast<MessageType>(read_1(m_raw_data.data()));
 }
 
-StockLocate_t Message::get_stock_locate() const
+MessageReader::~MessageReader()
 {
-  return static_cast<StockLocate_t>(read_2(m_raw_data.data() + 1));
+  if (m_buffer)
+  {
+    m_gzip->release(m_buffer);
+  }
 }
 
-TrackingNumber_t Message::get_tracking_number() const
+bool MessageReader::next(Message &message)
 {
-  return static_cast<TrackingNumber_t>(read_2(m_raw_data.data() + 3));
+  do
+  {
+    while (!read(message, m_pos))
+    {
+      if (!m_gzip || !next_buffer())
+      {
+        if (m_progress)
+        {
+          publish_progress();
+        }
+
+        return false;
+      }
+    }
+
+    m_pos += MESSAGE_LENGTH_SIZE + message.get_length();
+  } while (!m_wanted_types[static_cast<unsigned char>(message.get_type())]);
+
+  if (m_progress && (m_pos - m_published_pos >= ProgressCounters::BYTES_INTERVAL))
+  {
+    publish_progress();
+  }
+
+  return true;
 }
 
-Timestamp_t Message::get_timestamp() const
+void MessageReader::flush_progress()
 {
-  return static_cast<Timestamp_t>(read_6(m_raw_data.data() + 5));
+  if (m_progress)
+  {
+    publish_progress();
+  }
 }
 
-SystemEventType SystemMessage::get_event_type() const
+void MessageReader::publish_progress()
 {
-  return static_cast<SystemEventType>(read_1(m_raw_data.data() + 11));
+  m_progress->nr_bytes.fetch_add(m_pos - m_published_pos, std::memory_order_relaxed);
+  m_published_pos = m_pos;
 }
 
-OrderReferenceNumber_t AddOrderMessage::get_order_reference_number() const
+void decode_headers_scalar(MessageBlock &block, std::size_t begin, std::size_t end)
 {
-  return static_cast<OrderReferenceNumber_t>(read_8(m_raw_data.data() + 11));
+  for (auto i = begin; i < end; ++i)
+  {
+    const auto *body    = block.bodies[i];
+    block.types[i]      = static_cast<MessageType>(read_field<HeaderLayout::Type>(body));
+    block.locates[i]    = read_field<HeaderLayout::StockLocate>(body);
+    block.timestamps[i] = read_field<HeaderLayout::Timestamp>(body);
+  }
 }
 
-OrderType AddOrderMessage::get_order_type() const
+#if COMPILER_SUPPORTS_X86_DISPATCH
+// Moves the big endian timestamp (bytes 5-10) to the low 8 bytes and the locate (bytes 1-2) and type (byte 0) to the
+// next 3, little endian, with one shuffle of the first 16 bytes of a message
+#define HEADER_SHUFFLE 10, 9, 8, 7, 6, 5, -1, -1, 2, 1, 0, -1, -1, -1, -1, -1
+
+static_assert((0 == HeaderLayout::Type::OFFSET) && (1 == HeaderLayout::StockLocate::OFFSET) &&
+              (5 == HeaderLayout::Timestamp::OFFSET) && (HEADER_LOAD_SIZE >= HeaderLayout::Timestamp::END));
+
+inline void store_header(MessageBlock &block, std::size_t i, std::uint64_t timestamp, std::uint32_t locate_type)
 {
-  return static_cast<OrderType>(read_1(m_raw_data.data() + 19));
+  block.timestamps[i] = timestamp;
+  block.locates[i]    = static_cast<StockLocate_t>(locate_type);
+  block.types[i]      = static_cast<MessageType>(locate_type >> 16);
 }
 
-SharesCount_t AddOrderMessage::get_nr_shares() const
+__attribute__((target("ssse3"))) void decode_headers_ssse3(MessageBlock &block, std::size_t begin, std::size_t end)
 {
-  return static_cast<SharesCount_t>(read_4(m_raw_data.data() + 20));
+  const auto shuffle = _mm_setr_epi8(HEADER_SHUFFLE);
+
+  for (auto i = begin; i < end; ++i)
+  {
+    const auto header = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block.bodies[i]));
+    const auto fields = _mm_shuffle_epi8(header, shuffle);
+    store_header(block, i, _mm_cvtsi128_si64(fields), _mm_cvtsi128_si32(_mm_srli_si128(fields, 8)));
+  }
 }
 
-Stock_t AddOrderMessage::get_stock() const
+// Two headers per shuffle, one in each 128 bit lane
+__attribute__((target("avx2"))) void decode_headers_avx2(MessageBlock &block, std::size_t begin, std::size_t end)
 {
-  return read_string(m_raw_data.data() + 24, 8);
+  const auto shuffle = _mm256_setr_epi8(HEADER_SHUFFLE, HEADER_SHUFFLE);
+  auto       i       = begin;
+
+  for (; i + 2 <= end; i += 2)
+  {
+    const auto first   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block.bodies[i]));
+    const auto second  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block.bodies[i + 1]));
+    const auto headers = _mm256_inserti128_si256(_mm256_castsi128_si256(first), second, 1);
+    const auto fields  = _mm256_shuffle_epi8(headers, shuffle);
+    store_header(block, i, _mm256_extract_epi64(fields, 0), _mm256_extract_epi32(fields, 2));
+    store_header(block, i + 1, _mm256_extract_epi64(fields, 2), _mm256_extract_epi32(fields, 6));
+  }
+
+  decode_headers_ssse3(block, i, end);
 }
 
-Price_t AddOrderMessage::get_price() const
+#undef HEADER_SHUFFLE
+#endif
+
+using DecodeHeaders = void (*)(MessageBlock &block, std::size_t begin, std::size_t end);
+
+DecodeHeaders select_decode_headers()
 {
-  return read_4(m_raw_data.data() + 32) * PRICE_CONVERSION_FACTOR;
+#if COMPILER_SUPPORTS_X86_DISPATCH
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return decode_headers_avx2;
+  }
+
+  if (__builtin_cpu_supports("ssse3"))
+  {
+    return decode_headers_ssse3;
+  }
+#endif
+
+  return decode_headers_scalar;
 }
 
-Attribution_t AddOrderMPIDAttributionMessage::get_attribution() const
+const auto decode_headers = select_decode_headers();
+
+bool MessageReader::next_block(MessageBlock &block)
 {
-  return read_string(m_raw_data.data() + 36, 4);
+  block.size = 0;
+
+  // Only the boundaries within one buffer, a gzip reader moves on to the next one at the following call
+  while (true)
+  {
+    const auto end = m_base + m_size;
+    auto       pos = m_pos;
+
+    while ((block.size < MESSAGE_BLOCK_SIZE) && (pos + MESSAGE_LENGTH_SIZE <= end))
+    {
+      const auto *data   = m_data + (pos - m_base);
+      const auto  length = read_2(data);
+
+      if (pos + MESSAGE_LENGTH_SIZE + length > end)
+      {
+        break;
+      }
+
+      // Unwanted types are skipped before anything else is decoded, a wanted message only moves on the block size
+      block.bodies[block.size]  = data + MESSAGE_LENGTH_SIZE;
+      block.lengths[block.size] = length;
+      block.offsets[block.size] = pos;
+      block.size += (0 != length) && m_wanted_types[data[MESSAGE_LENGTH_SIZE]];
+      pos += MESSAGE_LENGTH_SIZE + length;
+    }
+
+    m_pos = pos;
+
+    if (block.size || !m_gzip || !next_buffer())
+    {
+      break;
+    }
+  }
+
+  if (m_progress)
+  {
+    publish_progress();
+  }
+
+  // Headers in a separate pass without the dependency on the previous message length. The vector decoders load
+  // HEADER_LOAD_SIZE bytes per header, so the last messages of the data are decoded one field at a time.
+  const auto *end_of_data = m_data + m_size;
+  auto        nr_loadable = block.size;
+
+  while (nr_loadable && (block.bodies[nr_loadable - 1] + HEADER_LOAD_SIZE > end_of_data))
+  {
+    --nr_loadable;
+  }
+
+  decode_headers(block, 0, nr_loadable);
+  decode_headers_scalar(block, nr_loadable, block.size);
+
+  // An empty block at the end of the data has no timestamp to take
+  if (block.size)
+  {
+    block.max_timestamp = *std::max_element(block.timestamps.begin(), block.timestamps.begin() + block.size);
+  }
+
+  return 0 != block.size;
 }
 
-OrderReferenceNumber_t OrderExecutedMessage::get_order_reference_number() const
+bool MessageReader::next_buffer()
 {
-  return static_cast<OrderReferenceNumber_t>(read_8(m_raw_data.data() + 11));
+  auto *buffer = m_gzip->acquire();
+
+  if (!buffer)
+  {
+    return false;
+  }
+
+  // Carry the partial message at the end of the current buffer over to the prefix of the new one
+  const auto carry = m_base + m_size - m_pos;
+  auto      *data  = buffer->data - carry;
+
+  if (carry)
+  {
+    std::memcpy(data, m_data + (m_pos - m_base), carry);
+  }
+
+  if (m_buffer)
+  {
+    m_gzip->release(m_buffer);
+  }
+
+  m_buffer = buffer;
+  m_data   = data;
+  m_size   = carry + buffer->size;
+  m_base   = m_pos;
+
+  return true;
 }
 
-SharesCount_t OrderExecutedMessage::get_nr_shares() const
+bool MessageReader::read(Message &message, size_t pos) const
 {
-  return static_cast<SharesCount_t>(read_4(m_raw_data.data() + 19));
+  if ((pos < m_base) || (pos + MESSAGE_LENGTH_SIZE > m_base + m_size))
+  {
+    return false;
+  }
+
+  const auto *data         = m_data + (pos - m_base);
+  const auto  message_size = read_2(data);
+
+  // request next message at cache
+  try_prefetch(data + MESSAGE_LENGTH_SIZE + message_size);
+
+  if (pos + MESSAGE_LENGTH_SIZE + message_size > m_base + m_size)
+  {
+    return false;
+  }
+
+  message = {std::span(data + MESSAGE_LENGTH_SIZE, message_size), pos};
+
+  return true;
 }
 
-MatchNumber_t OrderExecutedMessage::get_match_number() const
+StockTable::StockTable(std::size_t nr_periods, bool per_period)
+  : per_period(per_period), nr_bar_sets(per_period ? nr_periods : 1), bars(NR_STOCK_LOCATES * nr_bar_sets),
+    traded(nr_bar_sets), symbols(NR_STOCK_LOCATES)
 {
-  return static_cast<MatchNumber_t>(read_8(m_raw_data.data() + 23));
 }
 
-Printable OrderExecutedWithPriceMessage::get_printable() const
+void StockTable::set_bar(StockLocate_t locate, std::size_t bar_set, const Bar &bar)
 {
-  return static_cast<Printable>(read_1(m_raw_data.data() + 31));
+  auto &current = get_bar(locate, bar_set);
+
+  if ((0 == current.nr_trades) && (0 != bar.nr_trades))
+  {
+    traded[bar_set].push_back(locate);
+  }
+
+  current        = bar;
+  has_executions = has_executions || (0 != bar.nr_trades);
 }
 
-Price_t OrderExecutedWithPriceMessage::get_price() const
+void StockTable::clear(std::size_t period)
 {
-  return read_4(m_raw_data.data() + 32) * PRICE_CONVERSION_FACTOR;
+  if (!per_period)
+  {
+    return;
+  }
+
+  for (const auto locate : traded[period])
+  {
+    get_bar(locate, period) = Bar{};
+  }
+
+  traded[period].clear();
 }
 
-OrderReferenceNumber_t OrderReplaceMessage::get_original_order_reference_number() const
+void StockTable::clear()
 {
-  return static_cast<OrderReferenceNumber_t>(read_8(m_raw_data.data() + 11));
+  for (std::size_t bar_set = 0; bar_set < nr_bar_sets; ++bar_set)
+  {
+    for (const auto locate : traded[bar_set])
+    {
+      get_bar(locate, bar_set) = Bar{};
+    }
+
+    traded[bar_set].clear();
+  }
+
+  has_executions = false;
 }
 
-OrderReferenceNumber_t OrderReplaceMessage::get_new_order_reference_number() const
+ReportSchedule::ReportSchedule(const std::vector<Timestamp_t> &periods)
 {
-  return static_cast<OrderReferenceNumber_t>(read_8(m_raw_data.data() + 19));
+  for (const auto period : periods)
+  {
+    m_periods.push_back({period, 0});
+  }
+
+  update_next_report_time();
 }
 
-SharesCount_t OrderReplaceMessage::get_nr_shares() const
+void ReportSchedule::reset(Timestamp_t current_time)
 {
-  return static_cast<SharesCount_t>(read_4(m_raw_data.data() + 27));
+  for (auto &period : m_periods)
+  {
+    period.last_report_time = (current_time / period.length) * period.length;
+  }
+
+  update_next_report_time();
 }
 
-Price_t OrderReplaceMessage::get_price() const
+void ReportSchedule::update_next_report_time()
 {
-  return read_4(m_raw_data.data() + 31) * PRICE_CONVERSION_FACTOR;
+  m_next_report_time = std::numeric_limits<Timestamp_t>::max();
+
+  for (const auto &period : m_periods)
+  {
+    m_next_report_time = std::min(m_next_report_time, period.last_report_time + period.length);
+  }
 }
 
-OrderReferenceNumber_t OrderCancelMessage::get_order_reference_number() const
+void ReportSchedule::save(std::ostream &os) const
 {
-  return static_cast<OrderReferenceNumber_t>(read_8(m_raw_data.data() + 11));
+  write_binary(os, static_cast<std::uint64_t>(m_periods.size()));
+
+  for (const auto &period : m_periods)
+  {
+    write_binary(os, period.length);
+    write_binary(os, period.last_report_time);
+  }
 }
 
-SharesCount_t OrderCancelMessage::get_nr_shares() const
+std::vector<std::size_t> ReportSchedule::load(std::istream &is)
 {
-  return static_cast<OrderReferenceNumber_t>(read_8(m_raw_data.data() + 19));
+  std::vector<Period> saved(read_binary<std::uint64_t>(is));
+  Timestamp_t         latest_report_time{};
+
+  for (auto &period : saved)
+  {
+    period.length           = read_binary<Timestamp_t>(is);
+    period.last_report_time = read_binary<Timestamp_t>(is);
+    latest_report_time      = std::max(latest_report_time, period.last_report_time);
+  }
+
+  reset(latest_report_time);
+
+  std::vector<std::size_t> indexes(saved.size(), NO_PERIOD);
+
+  for (std::size_t index = 0; index < m_periods.size(); ++index)
+  {
+    auto      &period = m_periods[index];
+    const auto iter   = std::find_if(saved.begin(), saved.end(),
+                                     [&](const Period &other) { return other.length == period.length; });
+
+    if (saved.end() != iter)
+    {
+      period.last_report_time                                 = iter->last_report_time;
+      indexes[static_cast<std::size_t>(iter - saved.begin())] = index;
+    }
+  }
+
+  update_next_report_time();
+  return indexes;
 }
 
-OrderReferenceNumber_t OrderDeleteMessage::get_order_reference_number() const
+void log_system_event(Timestamp_t timestamp, SystemEventType event)
 {
-  return static_cast<OrderReferenceNumber_t>(read_8(m_raw_data.data() + 11));
+  static const auto event_logs = std::unordered_map<SystemEventType, std::string>{
+    {SystemEventType::StartMessages, "Start of Messages"},
+    {SystemEventType::StartSystemHours, "Start of System hours"},
+    {SystemEventType::StartMarketHours, "Start of Market hours"},
+    {SystemEventType::EndMarketHours, "End of Market hours"},
+    {SystemEventType::EndSystemHours, "End of System hours"},
+    {SystemEventType::EndMessages, "End of Messages"},
+  };
+
+  std::cout << Timestamp{timestamp} << " | " << event_logs.at(event) << std::endl;
 }
 
-OrderReferenceNumber_t TradeMessage::get_order_reference_number() const
+ReportWriter::~ReportWriter()
 {
-  return static_cast<OrderReferenceNumber_t>(read_8(m_raw_data.data() + 11));
+  {
+    const std::lock_guard lock(m_mutex);
+    m_done = true;
+  }
+
+  m_cv.notify_one();
+
+  if (m_thread.joinable())
+  {
+    m_thread.join();
+  }
 }
 
-OrderType TradeMessage::get_order_type() const
+// Stock_VWAP_HH.csv for hourly reports, Stock_VWAP_<period>_HHMM[SS].csv otherwise, e.g. Stock_VWAP_5m_0935.csv.
+// A report at the end of a time window between boundaries gets the minutes and seconds it needs, e.g.
+// Stock_VWAP_1450.csv.
+std::string get_report_filename(Timestamp_t period, Timestamp_t report_time)
 {
-  return static_cast<OrderType>(read_1(m_raw_data.data() + 19));
+  const auto        with_minutes = (HOUR_IN_NANOS != period) || (0 != report_time % HOUR_IN_NANOS);
+  const auto        with_seconds = (0 != period % MIN_IN_NANOS) || (0 != report_time % MIN_IN_NANOS);
+  std::stringstream filename;
+
+  filename << "Stock_VWAP_" << std::setfill('0');
+
+  if (HOUR_IN_NANOS != period)
+  {
+    if (0 == period % HOUR_IN_NANOS)
+    {
+      filename << period / HOUR_IN_NANOS << "h_";
+    }
+    else if (0 == period % MIN_IN_NANOS)
+    {
+      filename << period / MIN_IN_NANOS << "m_";
+    }
+    else
+    {
+      filename << period / SEC_IN_NANOS << "s_";
+    }
+  }
+
+  filename << std::setw(2) << report_time / HOUR_IN_NANOS;
+
+  if (with_minutes || with_seconds)
+  {
+    filename << std::setw(2) << (report_time / MIN_IN_NANOS) % 60;
+  }
+
+  if (with_seconds)
+  {
+    filename << std::setw(2) << (report_time / SEC_IN_NANOS) % 60;
+  }
+
+  filename << ".csv";
+  return filename.str();
 }
 
-SharesCount_t TradeMessage::get_nr_shares() const
+void ReportWriter::write(const StockTable &stocks, std::size_t index, Timestamp_t period, Timestamp_t report_time,
+                         Timestamp_t current_time)
 {
-  return static_cast<SharesCount_t>(read_4(m_raw_data.data() + 20));
+  Report     report;
+  const auto bar_set = stocks.get_bar_set(index);
+
+  for (const auto locate : stocks.traded[bar_set])
+  {
+    report.stocks.emplace_back(stocks.symbols[locate], stocks.get_bar(locate, bar_set));
+  }
+
+  report.filename = get_report_filename(period, report_time);
+
+  std::cout << Timestamp{current_time} << " | Reporting VWAP | " << report.filename << " | "
+            << report.stocks.size() << " stocks" << std::endl;
+
+  {
+    const std::lock_guard lock(m_mutex);
+    m_reports.push_back(std::move(report));
+  }
+
+  m_cv.notify_one();
+
+  if (!m_thread.joinable())
+  {
+    m_thread = std::thread(&ReportWriter::run, this);
+  }
 }
 
-Stock_t TradeMessage::get_stock() const
+void ReportWriter::format(const Report &report, std::string &buffer) const
 {
-  return read_string(m_raw_data.data() + 24, 8);
+  constexpr std::string_view header    = "Stock, VWAP, Open, High, Low, Close, Volume, Trades\n";
+  constexpr std::string_view separator = ", ";
+  constexpr auto             max_price = 10 + 1 + PRICE_DECIMALS;
+  constexpr auto             max_row =
+      sizeof(Stock_t) + 7 * separator.size() + (20 + 1 + MAX_VWAP_DECIMALS) + 4 * max_price + 2 * 20 + 1;
+
+  buffer.resize(header.size() + report.stocks.size() * max_row);
+
+  auto *out    = std::copy(header.begin(), header.end(), buffer.data());
+  auto  append = [&](std::string_view field) { out = std::copy(field.begin(), field.end(), out); };
+
+  for (const auto &[stock, bar] : report.stocks)
+  {
+    append(std::string_view(stock.data(), stock.size()));
+    append(separator);
+    out = format_vwap(out, bar, m_options.vwap_decimals);
+
+    for (const auto price : {bar.open, bar.high, bar.low, bar.close})
+    {
+      append(separator);
+      out = format_price(out, price);
+    }
+
+    append(separator);
+    out = std::to_chars(out, out + 20, bar.volume).ptr;
+    append(separator);
+    out    = std::to_chars(out, out + 20, bar.nr_trades).ptr;
+    *out++ = '\n';
+  }
+
+  buffer.resize(static_cast<std::size_t>(out - buffer.data()));
 }
 
-Price_t TradeMessage::get_price() const
+void ReportWriter::run()
 {
-  return read_4(m_raw_data.data() + 32) * PRICE_CONVERSION_FACTOR;
+  std::string buffer; // Reused across reports
+
+  while (true)
+  {
+    Report report;
+
+    {
+      std::unique_lock lock(m_mutex);
+      m_cv.wait(lock, [this] { return m_done || !m_reports.empty(); });
+
+      if (m_reports.empty())
+      {
+        return;
+      }
+
+      report = std::move(m_reports.front());
+      m_reports.pop_front();
+      m_writing = true;
+    }
+
+    // Symbols are only resolved here
+    std::sort(report.stocks.begin(), report.stocks.end(),
+              [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+
+    format(report, buffer);
+
+    // A single write, larger than the stream buffer so it goes straight to the file
+    std::ofstream ofs(report.filename, std::ios::binary);
+    ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    ofs.close();
+
+    if (!ofs)
+    {
+      std::cerr << "Failed to write " << report.filename << std::endl;
+    }
+
+    {
+      const std::lock_guard lock(m_mutex);
+      m_writing = false;
+    }
+
+    m_idle_cv.notify_all();
+  }
 }
 
-MatchNumber_t TradeMessage::get_match_number() const
+void ReportWriter::flush()
 {
-  return static_cast<MatchNumber_t>(read_8(m_raw_data.data() + 36));
+  std::unique_lock lock(m_mutex);
+  m_idle_cv.wait(lock, [this] { return m_reports.empty() && !m_writing; });
 }
 
-MatchNumber_t BrokenTradeMessage::get_match_number() const
+MessageHandler::MessageHandler(std::size_t initial_nr_orders, const ReportOptions &report_options)
+  : m_stocks(report_options.periods.size(), report_options.per_period), m_report_schedule(report_options.periods), m_report_writer(report_options),
+    m_symbols(report_options.symbols),
+    m_tracked_locates(NR_STOCK_LOCATES, m_symbols.empty())
 {
-  return static_cast<MatchNumber_t>(read_8(m_raw_data.data() + 11));
+  m_orders.reserve(initial_nr_orders);
 }
 
-MessageReader::MessageReader(std::string filename)
-  : m_file(filename, boost::iostreams::mapped_file::readonly), m_data((const unsigned char *)(m_file.const_data())),
-    m_size(m_file.size())
+MessageHandler::~MessageHandler() = default;
+
+// The fields of the message body, the header is already decoded
+void decode_body(const Message &message, DecodedMessage &decoded)
 {
-  if (!m_file.is_open() || !m_data || (0 == m_size))
+  // Fields are read without bounds checks, a message of a known type has to be as long as its layout
+  if (message.get_length() < MESSAGE_LENGTHS[static_cast<unsigned char>(decoded.type)])
   {
-    throw "Failed to open file!";
+    throw "Truncated message!";
+  }
+
+  switch (decoded.type)
+  {
+  // TODO Get rid of casting?
+  case MessageType::SystemEvent:
+  {
+    const auto &submessage = static_cast<const SystemMessage &>(message);
+    decoded.event          = submessage.get_event_type();
+    break;
+  }
+  case MessageType::StockDirectory:
+  {
+    const auto &submessage = static_cast<const StockDirectoryMessage &>(message);
+    decoded.stock          = submessage.get_stock();
+    break;
+  }
+  case MessageType::AddOrder:
+  case MessageType::AddOrderMPIDAttribution:
+  {
+    const auto &submessage         = static_cast<const AddOrderMessage &>(message);
+    decoded.order_reference_number = submessage.get_order_reference_number();
+    decoded.nr_shares              = submessage.get_nr_shares();
+    decoded.price                  = submessage.get_price();
+    break;
+  }
+  case MessageType::OrderReplace:
+  {
+    const auto &submessage             = static_cast<const OrderReplaceMessage &>(message);
+    decoded.order_reference_number     = submessage.get_original_order_reference_number();
+    decoded.new_order_reference_number = submessage.get_new_order_reference_number();
+    decoded.nr_shares                  = submessage.get_nr_shares();
+    decoded.price                      = submessage.get_price();
+    break;
+  }
+  case MessageType::OrderDelete:
+  {
+    const auto &submessage         = static_cast<const OrderDeleteMessage &>(message);
+    decoded.order_reference_number = submessage.get_order_reference_number();
+    break;
+  }
+  case MessageType::OrderCancel:
+  {
+    const auto &submessage         = static_cast<const OrderCancelMessage &>(message);
+    decoded.order_reference_number = submessage.get_order_reference_number();
+    decoded.nr_shares              = submessage.get_nr_shares();
+    break;
+  }
+  case MessageType::OrderExecuted:
+  {
+    const auto &submessage         = static_cast<const OrderExecutedMessage &>(message);
+    decoded.order_reference_number = submessage.get_order_reference_number();
+    decoded.nr_shares              = submessage.get_nr_shares();
+    break;
+  }
+  case MessageType::OrderExecutedWithPrice:
+  {
+    const auto &submessage         = static_cast<const OrderExecutedWithPriceMessage &>(message);
+    decoded.order_reference_number = submessage.get_order_reference_number();
+    decoded.nr_shares              = submessage.get_nr_shares();
+    decoded.printable              = submessage.get_printable();
+    decoded.price                  = submessage.get_price();
+    break;
+  }
+  case MessageType::Trade:
+  {
+    const auto &submessage = static_cast<const TradeMessage &>(message);
+    decoded.nr_shares      = submessage.get_nr_shares();
+    decoded.price          = submessage.get_price();
+    break;
+  }
+  default:
+    // Only the header is needed
+    break;
   }
 }
 
-bool MessageReader::next(Message &message)
+DecodedMessage decode(const Message &message)
+{
+  DecodedMessage decoded;
+  decoded.type      = message.get_type();
+  decoded.locate    = message.get_stock_locate();
+  decoded.timestamp = message.get_timestamp();
+  decode_body(message, decoded);
+  return decoded;
+}
+
+DecodedMessage MessageBlock::decode(std::size_t i) const
+{
+  DecodedMessage decoded;
+  decoded.type      = types[i];
+  decoded.locate    = locates[i];
+  decoded.timestamp = timestamps[i];
+  decode_body(get_message(i), decoded);
+  return decoded;
+}
+
+void MessageHandler::handle_message(const Message &message)
 {
-  const auto success = read(message, m_pos);
+  handle(decode(message));
+}
 
-  if (success)
+void MessageHandler::handle_block(const MessageBlock &block)
+{
+  if (m_perf_profile && block.size)
   {
-    m_pos += MESSAGE_LENGTH_SIZE + message.get_length();
+    m_perf_profile->set_time(block.max_timestamp);
+  }
+
+  if (m_report_schedule.is_due(block.max_timestamp))
+  {
+    for (std::size_t i = 0; i < block.size; ++i)
+    {
+      handle(block.decode(i));
+    }
+
+    return;
   }
 
-  return success;
+  for (std::size_t i = 0; i < block.size; ++i)
+  {
+    process(block.decode(i));
+  }
 }
 
-bool MessageReader::read(Message &message, size_t pos) const
+void MessageHandler::handle(const DecodedMessage &message)
 {
-  if (pos + MESSAGE_LENGTH_SIZE > m_size)
+  if (m_perf_profile)
   {
-    return false;
+    m_perf_profile->set_time(message.timestamp);
   }
 
-  const auto message_size = read_2(m_data + pos);
+  report(message.timestamp);
+  process(message);
+}
 
-  // request next message at cache
-  try_prefetch(m_data + pos + MESSAGE_LENGTH_SIZE + message_size);
+void MessageHandler::enable_stats()
+{
+  m_stats = std::make_unique<HandlerStats>();
+}
+
+void MessageHandler::set_progress(ProgressCounters *progress)
+{
+  m_progress                = progress;
+  m_nr_unpublished_messages = 0;
+  m_published_nr_orders     = 0; // The orders already in the book are added by the first publish
+}
 
-  if (pos + MESSAGE_LENGTH_SIZE + message_size > m_size)
+void MessageHandler::process(const DecodedMessage &message)
+{
+  if (!m_stats && !m_progress)
   {
-    return false;
+    process_message(message);
+    return;
   }
 
-  message = {std::span(m_data + pos + MESSAGE_LENGTH_SIZE, message_size), pos};
+  if (!m_stats)
+  {
+    process_message(message);
+  }
+  else
+  {
+    const auto start = read_ticks();
+    process_message(message);
+    m_stats->record(message.type, read_ticks() - start);
 
-  return true;
+    if (m_stats->is_sample_due(message.timestamp))
+    {
+      m_stats->sample(message.timestamp, m_orders.size(), m_orders.capacity());
+    }
+  }
+
+  if (m_progress)
+  {
+    m_last_timestamp = message.timestamp;
+
+    if (++m_nr_unpublished_messages == ProgressCounters::MESSAGES_INTERVAL)
+    {
+      publish_progress();
+    }
+  }
 }
 
-MessageHandler::MessageHandler()
+void MessageHandler::flush_progress()
 {
-  // TODO Find optimum initial size
-  constexpr auto initial_size = 32 * 1024 * 1024;
-  m_orders.reserve(initial_size);
+  if (m_progress)
+  {
+    publish_progress();
+  }
 }
 
-void MessageHandler::handle_message(const Message &message)
+void MessageHandler::publish_progress()
 {
-  //  static std::unordered_map<MessageType, size_t> counts;
-  //  counts[message.get_type()]++;
+  // The unsigned difference wraps, so adding it takes the total back when the book shrank
+  m_progress->nr_messages.fetch_add(m_nr_unpublished_messages, std::memory_order_relaxed);
+  m_progress->nr_orders.fetch_add(m_orders.size() - m_published_nr_orders, std::memory_order_relaxed);
 
-  const auto timestamp = message.get_timestamp();
-  report(timestamp);
+  // The latest of the shards
+  auto timestamp = m_progress->timestamp.load(std::memory_order_relaxed);
 
-  switch (message.get_type())
+  while ((timestamp < m_last_timestamp) &&
+         !m_progress->timestamp.compare_exchange_weak(timestamp, m_last_timestamp, std::memory_order_relaxed))
   {
-  // TODO Get rid of casting?
-  case MessageType::SystemEvent:
+  }
+
+  m_nr_unpublished_messages = 0;
+  m_published_nr_orders     = m_orders.size();
+}
+
+void MessageHandler::process_message(const DecodedMessage &message)
+{
+  // The orders of stocks not on the allow-list are dropped by their locate, before any order map lookup
+  if (!m_tracked_locates[message.locate] && (MessageType::SystemEvent != message.type) &&
+      (MessageType::StockDirectory != message.type))
   {
-    static const auto event_logs = std::unordered_map<SystemEventType, std::string>{
-      {SystemEventType::StartMessages, "Start of Messages"},
-      {SystemEventType::StartSystemHours, "Start of System hours"},
-      {SystemEventType::StartMarketHours, "Start of Market hours"},
-      {SystemEventType::EndMarketHours, "End of Market hours"},
-      {SystemEventType::EndSystemHours, "End of System hours"},
-      {SystemEventType::EndMessages, "End of Messages"},
-    };
+    return;
+  }
 
-    const auto &submessage = static_cast<const SystemMessage &>(message);
-    std::cout << Timestamp{timestamp} << " | " << event_logs.at(submessage.get_event_type()) << std::endl;
+  switch (message.type)
+  {
+  case MessageType::SystemEvent:
+  {
+    log_system_event(message.timestamp, message.event);
+    break;
+  }
+  case MessageType::StockDirectory:
+  {
+    add_stock(message.locate, message.stock);
     break;
   }
   case MessageType::AddOrder:
   case MessageType::AddOrderMPIDAttribution:
   {
-    const auto &submessage = static_cast<const AddOrderMessage &>(message);
-    m_orders.try_emplace(submessage.get_order_reference_number(), submessage.get_stock(), submessage.get_price());
+    m_orders.try_emplace(message.order_reference_number, message.locate, message.price, message.nr_shares);
     break;
   }
   case MessageType::OrderReplace:
   {
-    const auto &submessage = static_cast<const OrderReplaceMessage &>(message);
-    const auto  iter_order = m_orders.find(submessage.get_original_order_reference_number());
+    auto order = OrderInfo{};
 
-    if (m_orders.end() != iter_order)
+    if (m_orders.extract(message.order_reference_number, order))
     {
-      const auto &order = iter_order->second;
-      m_orders.try_emplace(submessage.get_new_order_reference_number(), order.stock, submessage.get_price());
-      m_orders.erase(iter_order);
+      m_orders.try_emplace(message.new_order_reference_number, order.locate, message.price, message.nr_shares);
     }
     break;
   }
   case MessageType::OrderDelete:
   {
-    const auto &submessage = static_cast<const OrderDeleteMessage &>(message);
-    m_orders.erase(submessage.get_order_reference_number());
+    m_orders.erase(message.order_reference_number);
     break;
   }
   case MessageType::OrderCancel:
   {
-    // TODO Check if it is worth to remove an order with zero remanining shares
+    auto *order = m_orders.find(message.order_reference_number);
+
+    if (order)
+    {
+      reduce_order(message.order_reference_number, *order, message.nr_shares);
+    }
+
     break;
   }
   case MessageType::OrderExecuted:
   {
-    const auto &submessage = static_cast<const OrderExecutedMessage &>(message);
-    const auto  iter_order = m_orders.find(submessage.get_order_reference_number());
+    auto *order = m_orders.find(message.order_reference_number);
 
-    if (m_orders.end() != iter_order)
+    if (order)
     {
-      const auto &order = iter_order->second;
-      execute_order(order.stock, submessage.get_nr_shares(), order.price);
+      execute_order(order->locate, message.nr_shares, order->price);
+      reduce_order(message.order_reference_number, *order, message.nr_shares);
     }
 
     break;
   }
   case MessageType::OrderExecutedWithPrice:
   {
-    const auto &submessage = static_cast<const OrderExecutedWithPriceMessage &>(message);
+    auto *order = m_orders.find(message.order_reference_number);
 
-    if (Printable::Yes == submessage.get_printable())
+    if (order)
     {
-      const auto iter_order = m_orders.find(submessage.get_order_reference_number());
-
-      if (m_orders.end() != iter_order)
+      // Non-printable executions still take shares off the book
+      if (Printable::Yes == message.printable)
       {
-        const auto &order = iter_order->second;
-        execute_order(order.stock, submessage.get_nr_shares(), submessage.get_price());
+        execute_order(order->locate, message.nr_shares, message.price);
       }
+
+      reduce_order(message.order_reference_number, *order, message.nr_shares);
     }
+
     break;
   }
   case MessageType::Trade:
   {
-    const auto &submessage = static_cast<const TradeMessage &>(message);
-    execute_order(submessage.get_stock(), submessage.get_nr_shares(), submessage.get_price());
+    execute_order(message.locate, message.nr_shares, message.price);
     break;
   }
   case MessageType::BrokenTrade:
@@ -432,42 +1094,187 @@ void MessageHandler::handle_message(const Message &message)
   }
 }
 
-void MessageHandler::execute_order(Stock_t stock, SharesCount_t nr_shares, Price_t price)
+void MessageHandler::add_stock(StockLocate_t locate, const Stock_t &stock)
 {
-  auto &stock_info = m_stocks[stock];
+  m_stocks.symbols[locate] = stock;
 
-  stock_info.volume += nr_shares;
-  stock_info.price += nr_shares * price;
+  if (!m_symbols.empty())
+  {
+    m_tracked_locates[locate] = std::binary_search(m_symbols.begin(), m_symbols.end(), stock);
+  }
+}
+
+void MessageHandler::reduce_order(OrderReferenceNumber_t order_reference_number, OrderInfo &order,
+                                  SharesCount_t nr_shares)
+{
+  // Fully executed or cancelled orders are not deleted by an OrderDelete, keeping them would only grow the map
+  if (nr_shares >= order.nr_shares)
+  {
+    m_orders.erase(order_reference_number);
+  }
+  else
+  {
+    order.nr_shares -= nr_shares;
+  }
+}
+
+void MessageHandler::execute_order(StockLocate_t locate, SharesCount_t nr_shares, Price_t price)
+{
+  m_stocks.add(locate, nr_shares, price);
 }
 
 void MessageHandler::report(const Timestamp_t &current_time)
 {
-  if (m_stocks.empty() || (current_time < m_last_report_time + REPORT_PERIOD))
+  if (!m_report_schedule.is_due(current_time))
   {
     return;
   }
 
-  m_last_report_time = std::max(m_last_report_time, (current_time / REPORT_PERIOD) * REPORT_PERIOD);
+  if (m_perf_profile)
+  {
+    m_perf_profile->set_phase(PerfProfile::Reporting);
+  }
 
-  const auto        hour = m_last_report_time / REPORT_PERIOD;
-  std::stringstream filename;
+  // The schedule moves on from the first message, so the first execution is reported with the period it is in, but no
+  // report is written before it
+  m_report_schedule.advance(current_time, [&](std::size_t index, Timestamp_t period, Timestamp_t report_time) {
+    if (m_stocks.has_executions)
+    {
+      m_report_writer.write(m_stocks, index, period, report_time, current_time);
+      m_stocks.clear(index);
+    }
+  });
 
-  filename << "Stock_VWAP_" << std::setw(2) << std::setfill('0') << hour << ".csv";
+  if (m_perf_profile)
+  {
+    m_perf_profile->set_phase(PerfProfile::Parsing);
+  }
+}
+
+void MessageHandler::start_window(Timestamp_t start)
+{
+  m_stocks.clear();
+  m_report_schedule.reset(start);
+}
+
+void MessageHandler::close_window(Timestamp_t end)
+{
+  report(end);
+
+  m_report_schedule.close(end, [&](std::size_t index, Timestamp_t period, Timestamp_t report_time) {
+    m_report_writer.write(m_stocks, index, period, report_time, end);
+    m_stocks.clear(index);
+  });
+}
+
+void MessageHandler::save(std::ostream &os) const
+{
+  // The options the state depends on, the allow-list sorted
+  write_binary(os, m_stocks.per_period);
+  write_binary(os, static_cast<std::uint64_t>(m_symbols.size()));
+
+  for (const auto &symbol : m_symbols)
+  {
+    write_binary(os, symbol);
+  }
+
+  m_report_schedule.save(os);
+  write_binary(os, m_stocks.has_executions);
+
+  std::vector<StockLocate_t> locates;
+
+  for (std::size_t bar_set = 0; bar_set < m_stocks.nr_bar_sets; ++bar_set)
+  {
+    locates.insert(locates.end(), m_stocks.traded[bar_set].begin(), m_stocks.traded[bar_set].end());
+  }
+
+  for (std::size_t locate = 0; locate < NR_STOCK_LOCATES; ++locate)
+  {
+    if (Stock_t{} != m_stocks.symbols[locate])
+    {
+      locates.push_back(static_cast<StockLocate_t>(locate));
+    }
+  }
+
+  std::sort(locates.begin(), locates.end());
+  locates.erase(std::unique(locates.begin(), locates.end()), locates.end());
+
+  write_binary(os, static_cast<std::uint64_t>(locates.size()));
 
-  std::cout << Timestamp{current_time} << " | Reporting VWAP | " << filename.str() << " | " << m_stocks.size()
-            << " stocks" << std::endl;
+  // The day to date bars, or the bars of every period in the order of the periods saved by the report schedule
+  for (const auto locate : locates)
+  {
+    write_binary(os, locate);
+    write_binary(os, m_stocks.symbols[locate]);
+
+    for (std::size_t bar_set = 0; bar_set < m_stocks.nr_bar_sets; ++bar_set)
+    {
+      write_binary(os, m_stocks.get_bar(locate, bar_set));
+    }
+  }
+
+  write_binary(os, static_cast<std::uint64_t>(m_orders.size()));
+
+  m_orders.for_each([&](OrderReferenceNumber_t order_reference_number, const OrderInfo &order) {
+    write_binary(os, order_reference_number);
+    write_binary(os, order.price);
+    write_binary(os, order.nr_shares);
+    write_binary(os, order.locate);
+  });
+}
 
-  // TODO Check I/O time (async?)
-  std::ofstream ofs(filename.str());
+void MessageHandler::load(std::istream &is)
+{
+  // Per period bars can't be told from day to date ones and the orders of stocks off the allow-list are missing,
+  // checked before anything is loaded
+  const auto           per_period = read_binary<bool>(is);
+  std::vector<Stock_t> symbols;
 
-  ofs << "Stock, VWAP" << std::endl;
+  for (auto nr_symbols = read_binary<std::uint64_t>(is); nr_symbols; --nr_symbols)
+  {
+    symbols.push_back(read_binary<Stock_t>(is));
+  }
 
-  for (const auto &[stock, price_volume] : m_stocks)
+  if ((per_period != m_stocks.per_period) || (symbols != m_symbols))
   {
-    const auto VWAP = ((0.0 == price_volume.volume) ? 0.0 : (price_volume.price / price_volume.volume));
+    throw "Snapshot taken with other report options!";
+  }
+
+  const auto periods    = m_report_schedule.load(is);
+  const auto executions = read_binary<bool>(is);
 
-    // TODO Is it worth to write with async I/O?
-    ofs << stock << ", " << VWAP << std::endl;
+  for (auto nr_stocks = read_binary<std::uint64_t>(is); nr_stocks; --nr_stocks)
+  {
+    const auto locate = read_binary<StockLocate_t>(is);
+    add_stock(locate, read_binary<Stock_t>(is));
+
+    if (!m_stocks.per_period)
+    {
+      m_stocks.set_bar(locate, 0, read_binary<Bar>(is));
+      continue;
+    }
+
+    // The bars of periods no longer reported are dropped, new periods start empty
+    for (const auto period : periods)
+    {
+      const auto bar = read_binary<Bar>(is);
+
+      if (ReportSchedule::NO_PERIOD != period)
+      {
+        m_stocks.set_bar(locate, period, bar);
+      }
+    }
+  }
+
+  m_stocks.has_executions = executions;
+
+  for (auto nr_orders = read_binary<std::uint64_t>(is); nr_orders; --nr_orders)
+  {
+    const auto order_reference_number = read_binary<OrderReferenceNumber_t>(is);
+    const auto price                  = read_binary<Price_t>(is);
+    const auto nr_shares              = read_binary<SharesCount_t>(is);
+    const auto locate                 = read_binary<StockLocate_t>(is);
+    m_orders.try_emplace(order_reference_number, locate, price, nr_shares);
   }
 }
 
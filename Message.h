@@ -20,24 +20,32 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
-#include "ankerl/unordered_dense.h"
-#include <boost/container/flat_map.hpp>
+#pragma once
+
+#include "MessageLayout.h"
+#include "OrderMap.h"
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <boost/iostreams/device/mapped_file.hpp>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <initializer_list>
+#include <iosfwd>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <span>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace ITCH
 {
 
-// TODO Benchmark further -> compare with sparse map and flat map
-template <typename K, typename V> using HashMap = ankerl::unordered_dense::map<K, V>;
-// template <typename K, typename V> using HashMap = ankerl::unordered_dense::segmented_map<K, V>;
-// template <typename K, typename V> using HashMap = boost::unordered_map<K, V>;
-// TODO Segfaulting at key comparison during erase!? Fixable?
-// template <typename K, typename V> using HashMap = btree::map<K, V>;
-// template <typename K, typename V> using TreeMap = boost::container::map<K, V>;
-template <typename K, typename V> using TreeMap = boost::container::flat_map<K, V>;
-
 enum MessageType : char
 {
   SystemEvent                                 = 'S',
@@ -90,14 +98,27 @@ enum Printable : char
 using Attribution_t          = std::string_view;
 using MatchNumber_t          = std::uint64_t;
 using OrderReferenceNumber_t = std::uint64_t;
-using Price_t                = double;
+using Price_t                = std::uint32_t; // Price(4), fixed point with 4 decimals
+#ifdef COMPILER_SUPPORTS_INT128
+using Notional_t = unsigned __int128; // Sum of Price(4) * shares
+#else
+using Notional_t = std::uint64_t; // Sum of Price(4) * shares, a stock's daily notional stays well below 2^64
+#endif
 using SharesCount_t          = std::uint32_t;
 using StockLocate_t          = std::uint16_t;
 // using Stock_t                = std::string;   // TODO 9% cycle time, change to char[]?
-using Stock_t          = std::string_view;
+// Owns the (space padded) symbol, messages of a gzip stream do not outlive their decompression buffer
+using Stock_t          = std::array<char, 8>;
 using Timestamp_t      = std::uint64_t; // 48-bit
 using TrackingNumber_t = std::uint16_t;
 
+constexpr Timestamp_t SEC_IN_NANOS  = 1'000'000'000;
+constexpr Timestamp_t MIN_IN_NANOS  = 60 * SEC_IN_NANOS;
+constexpr Timestamp_t HOUR_IN_NANOS = 60 * MIN_IN_NANOS;
+
+constexpr std::size_t NR_STOCK_LOCATES    = 1 << (8 * sizeof(StockLocate_t));
+constexpr std::size_t MESSAGE_LENGTH_SIZE = 2; // Length prefix of every message in the file
+
 class Message
 {
 public:
@@ -127,6 +148,12 @@ public:
   SystemEventType get_event_type() const;
 };
 
+class StockDirectoryMessage : public Message
+{
+public:
+  Stock_t get_stock() const;
+};
+
 class AddOrderMessage : public Message
 {
 public:
@@ -199,53 +226,758 @@ public:
 
 std::ostream &operator<<(std::ostream &ss, const Message &message);
 
+// Big endian fields of the messages, unaligned loads and byte swaps
+template <typename T> T load(const unsigned char *bytes)
+{
+  T value;
+  std::memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+inline std::uint16_t byteswap(std::uint16_t value)
+{
+#if COMPILER_SUPPORTS_BUILTIN_BSWAP
+  return __builtin_bswap16(value);
+#else
+  return static_cast<std::uint16_t>((value << 8) | (value >> 8));
+#endif
+}
+
+inline std::uint32_t byteswap(std::uint32_t value)
+{
+#if COMPILER_SUPPORTS_BUILTIN_BSWAP
+  return __builtin_bswap32(value);
+#else
+  return (value << 24) | ((value << 8) & 0x00FF0000u) | ((value >> 8) & 0x0000FF00u) | (value >> 24);
+#endif
+}
+
+inline std::uint64_t byteswap(std::uint64_t value)
+{
+#if COMPILER_SUPPORTS_BUILTIN_BSWAP
+  return __builtin_bswap64(value);
+#else
+  return (std::uint64_t{byteswap(static_cast<std::uint32_t>(value))} << 32) |
+         byteswap(static_cast<std::uint32_t>(value >> 32));
+#endif
+}
+
+template <typename T> T from_big_endian(T value)
+{
+  return (std::endian::native == std::endian::big) ? value : byteswap(value);
+}
+
+inline std::string_view read_string(const unsigned char *bytes, std::size_t length)
+{
+  return std::string_view(reinterpret_cast<const char *>(bytes), length);
+}
+
+inline Stock_t read_stock(const unsigned char *bytes)
+{
+  return load<Stock_t>(bytes);
+}
+
+inline std::uint8_t read_1(const unsigned char *bytes)
+{
+  return bytes[0];
+}
+
+inline std::uint16_t read_2(const unsigned char *bytes)
+{
+  return from_big_endian(load<std::uint16_t>(bytes));
+}
+
+inline std::uint32_t read_4(const unsigned char *bytes)
+{
+  return from_big_endian(load<std::uint32_t>(bytes));
+}
+
+inline std::uint64_t read_6(const unsigned char *bytes)
+{
+  // The 6 bytes in the upper part of a big endian 8 byte value
+  std::uint64_t value{};
+  std::memcpy(&value, bytes, 6);
+  return from_big_endian(value) >> ((std::endian::native == std::endian::big) ? 0 : 16);
+}
+
+inline std::uint64_t read_8(const unsigned char *bytes)
+{
+  return from_big_endian(load<std::uint64_t>(bytes));
+}
+
+// A field of a message, an integer or a char, or an array of chars for longer alpha fields such as Stock_t
+template <typename F> auto read_field(const unsigned char *message)
+{
+  const auto *bytes = message + F::OFFSET;
+
+  if constexpr (F::ALPHA && (1 == F::SIZE))
+  {
+    return static_cast<char>(read_1(bytes));
+  }
+  else if constexpr (F::ALPHA)
+  {
+    return load<std::array<char, F::SIZE>>(bytes);
+  }
+  else if constexpr (1 == F::SIZE)
+  {
+    return read_1(bytes);
+  }
+  else if constexpr (2 == F::SIZE)
+  {
+    return read_2(bytes);
+  }
+  else if constexpr (4 == F::SIZE)
+  {
+    return read_4(bytes);
+  }
+  else if constexpr (6 == F::SIZE)
+  {
+    return read_6(bytes);
+  }
+  else
+  {
+    static_assert(8 == F::SIZE);
+    return read_8(bytes);
+  }
+}
+
+// Typed view of any message by its layout, e.g. MessageView<CrossTradeLayout>{message}.get<CrossTradeLayout::Shares>()
+template <typename Layout> class MessageView : public Message
+{
+public:
+  explicit MessageView(const Message &message) : Message(message)
+  {
+  }
+
+  template <typename F> auto get() const
+  {
+    static_assert(F::END <= Layout::LENGTH);
+    return read_field<F>(m_raw_data.data());
+  }
+};
+
+inline std::size_t Message::get_offset() const
+{
+  return m_pos;
+}
+
+inline std::size_t Message::get_length() const
+{
+  return m_raw_data.size();
+}
+
+inline MessageType Message::get_type() const
+{
+  return static_cast<MessageType>(read_field<HeaderLayout::Type>(m_raw_data.data()));
+}
+
+inline StockLocate_t Message::get_stock_locate() const
+{
+  return static_cast<StockLocate_t>(read_field<HeaderLayout::StockLocate>(m_raw_data.data()));
+}
+
+inline TrackingNumber_t Message::get_tracking_number() const
+{
+  return static_cast<TrackingNumber_t>(read_field<HeaderLayout::TrackingNumber>(m_raw_data.data()));
+}
+
+inline Timestamp_t Message::get_timestamp() const
+{
+  return static_cast<Timestamp_t>(read_field<HeaderLayout::Timestamp>(m_raw_data.data()));
+}
+
+inline SystemEventType SystemMessage::get_event_type() const
+{
+  return static_cast<SystemEventType>(read_field<SystemEventLayout::EventCode>(m_raw_data.data()));
+}
+
+inline Stock_t StockDirectoryMessage::get_stock() const
+{
+  return read_field<StockDirectoryLayout::Stock>(m_raw_data.data());
+}
+
+inline OrderReferenceNumber_t AddOrderMessage::get_order_reference_number() const
+{
+  return static_cast<OrderReferenceNumber_t>(read_field<AddOrderLayout::OrderReferenceNumber>(m_raw_data.data()));
+}
+
+inline OrderType AddOrderMessage::get_order_type() const
+{
+  return static_cast<OrderType>(read_field<AddOrderLayout::BuySellIndicator>(m_raw_data.data()));
+}
+
+inline SharesCount_t AddOrderMessage::get_nr_shares() const
+{
+  return static_cast<SharesCount_t>(read_field<AddOrderLayout::Shares>(m_raw_data.data()));
+}
+
+inline Stock_t AddOrderMessage::get_stock() const
+{
+  return read_field<AddOrderLayout::Stock>(m_raw_data.data());
+}
+
+inline Price_t AddOrderMessage::get_price() const
+{
+  return static_cast<Price_t>(read_field<AddOrderLayout::Price>(m_raw_data.data()));
+}
+
+inline Attribution_t AddOrderMPIDAttributionMessage::get_attribution() const
+{
+  return read_string(m_raw_data.data() + AddOrderMPIDAttributionLayout::Attribution::OFFSET,
+                     AddOrderMPIDAttributionLayout::Attribution::SIZE);
+}
+
+inline OrderReferenceNumber_t OrderExecutedMessage::get_order_reference_number() const
+{
+  return static_cast<OrderReferenceNumber_t>(read_field<OrderExecutedLayout::OrderReferenceNumber>(m_raw_data.data()));
+}
+
+inline SharesCount_t OrderExecutedMessage::get_nr_shares() const
+{
+  return static_cast<SharesCount_t>(read_field<OrderExecutedLayout::ExecutedShares>(m_raw_data.data()));
+}
+
+inline MatchNumber_t OrderExecutedMessage::get_match_number() const
+{
+  return static_cast<MatchNumber_t>(read_field<OrderExecutedLayout::MatchNumber>(m_raw_data.data()));
+}
+
+inline Printable OrderExecutedWithPriceMessage::get_printable() const
+{
+  return static_cast<Printable>(read_field<OrderExecutedWithPriceLayout::Printable>(m_raw_data.data()));
+}
+
+inline Price_t OrderExecutedWithPriceMessage::get_price() const
+{
+  return static_cast<Price_t>(read_field<OrderExecutedWithPriceLayout::ExecutionPrice>(m_raw_data.data()));
+}
+
+inline OrderReferenceNumber_t OrderReplaceMessage::get_original_order_reference_number() const
+{
+  return read_field<OrderReplaceLayout::OriginalOrderReferenceNumber>(m_raw_data.data());
+}
+
+inline OrderReferenceNumber_t OrderReplaceMessage::get_new_order_reference_number() const
+{
+  return read_field<OrderReplaceLayout::NewOrderReferenceNumber>(m_raw_data.data());
+}
+
+inline SharesCount_t OrderReplaceMessage::get_nr_shares() const
+{
+  return static_cast<SharesCount_t>(read_field<OrderReplaceLayout::Shares>(m_raw_data.data()));
+}
+
+inline Price_t OrderReplaceMessage::get_price() const
+{
+  return static_cast<Price_t>(read_field<OrderReplaceLayout::Price>(m_raw_data.data()));
+}
+
+inline OrderReferenceNumber_t OrderCancelMessage::get_order_reference_number() const
+{
+  return static_cast<OrderReferenceNumber_t>(read_field<OrderCancelLayout::OrderReferenceNumber>(m_raw_data.data()));
+}
+
+inline SharesCount_t OrderCancelMessage::get_nr_shares() const
+{
+  return static_cast<SharesCount_t>(read_field<OrderCancelLayout::CancelledShares>(m_raw_data.data()));
+}
+
+inline OrderReferenceNumber_t OrderDeleteMessage::get_order_reference_number() const
+{
+  return static_cast<OrderReferenceNumber_t>(read_field<OrderDeleteLayout::OrderReferenceNumber>(m_raw_data.data()));
+}
+
+inline OrderReferenceNumber_t TradeMessage::get_order_reference_number() const
+{
+  return static_cast<OrderReferenceNumber_t>(read_field<TradeLayout::OrderReferenceNumber>(m_raw_data.data()));
+}
+
+inline OrderType TradeMessage::get_order_type() const
+{
+  return static_cast<OrderType>(read_field<TradeLayout::BuySellIndicator>(m_raw_data.data()));
+}
+
+inline SharesCount_t TradeMessage::get_nr_shares() const
+{
+  return static_cast<SharesCount_t>(read_field<TradeLayout::Shares>(m_raw_data.data()));
+}
+
+inline Stock_t TradeMessage::get_stock() const
+{
+  return read_field<TradeLayout::Stock>(m_raw_data.data());
+}
+
+inline Price_t TradeMessage::get_price() const
+{
+  return static_cast<Price_t>(read_field<TradeLayout::Price>(m_raw_data.data()));
+}
+
+inline MatchNumber_t TradeMessage::get_match_number() const
+{
+  return static_cast<MatchNumber_t>(read_field<TradeLayout::MatchNumber>(m_raw_data.data()));
+}
+
+inline MatchNumber_t BrokenTradeMessage::get_match_number() const
+{
+  return static_cast<MatchNumber_t>(read_field<BrokenTradeLayout::MatchNumber>(m_raw_data.data()));
+}
+
+// Wanted message types, indexed by MessageType
+using MessageTypeFilter = std::array<bool, 256>;
+
+constexpr MessageTypeFilter make_type_filter(std::initializer_list<MessageType> types)
+{
+  MessageTypeFilter filter{};
+
+  for (const auto type : types)
+  {
+    filter[static_cast<unsigned char>(type)] = true;
+  }
+
+  return filter;
+}
+
+constexpr MessageTypeFilter ALL_MESSAGE_TYPES = [] {
+  MessageTypeFilter filter{};
+  filter.fill(true);
+  return filter;
+}();
+
+struct GzipBuffer;
+class GzipReader;
+struct MessageBlock;
+struct ProgressCounters;
+
+// Memory maps a decompressed file, or streams a gzip compressed one (*.gz) through a background decompressor.
+// In streaming mode a message is only valid until the next call to next() and read() can only access
+// positions within the current decompression buffer.
 class MessageReader
 {
 public:
   MessageReader(std::string filename);
+  // Reads the messages in [begin, end) of a memory mapped reader, begin has to be a message boundary
+  MessageReader(const MessageReader &reader, std::size_t begin, std::size_t end);
+  // Reads the messages of a buffer in memory, which has to outlive the reader
+  explicit MessageReader(std::span<const char> data);
+  ~MessageReader();
+
+  // next() and next_block() skip the messages of unwanted types by their length prefix only, all are wanted by default
+  void set_type_filter(const MessageTypeFilter &wanted_types)
+  {
+    m_wanted_types = wanted_types;
+  }
+
+  // Adds the bytes read to counters from now on, inherited by the readers of its chunks
+  void set_progress(ProgressCounters *progress)
+  {
+    m_progress      = progress;
+    m_published_pos = m_pos;
+  }
+
+  // Adds the bytes read since the last addition, which happens by itself every block and at the end of the data
+  void flush_progress();
 
   bool next(Message &message);
+  // Fills block with the next messages, up to MESSAGE_BLOCK_SIZE of them, false at the end
+  bool next_block(MessageBlock &block);
   bool read(Message &message, size_t pos) const;
 
+  bool is_mapped() const
+  {
+    return !m_gzip;
+  }
+
+  // Size of a memory mapped file
+  std::size_t get_size() const
+  {
+    return m_size;
+  }
+
 private:
+  bool next_buffer();
+  void publish_progress();
+
   boost::iostreams::mapped_file m_file;
+  std::unique_ptr<GzipReader>   m_gzip;
+  GzipBuffer                   *m_buffer{};
   std::size_t                   m_pos{};
-  const unsigned char          *m_data;
-  const std::size_t             m_size{};
+  const unsigned char          *m_data{};
+  std::size_t                   m_size{};
+  std::size_t                   m_base{}; // Stream offset of m_data[0]
+  MessageTypeFilter             m_wanted_types = ALL_MESSAGE_TYPES;
+  ProgressCounters             *m_progress{};
+  std::size_t                   m_published_pos{};
 };
 
-struct VolumePrice
+// Fields of a message needed by the MessageHandler, decoded up front so reading and decoding can run on another
+// thread than the handler. Unused fields of a message type are left zero.
+struct DecodedMessage
 {
-  double volume{};
-  double price{};
+  Timestamp_t            timestamp{};
+  OrderReferenceNumber_t order_reference_number{};
+  OrderReferenceNumber_t new_order_reference_number{}; // OrderReplace
+  Stock_t                stock{};                      // StockDirectory
+  SharesCount_t          nr_shares{};
+  Price_t                price{};
+  StockLocate_t          locate{};
+  MessageType            type{};
+  SystemEventType        event{};     // SystemEvent
+  Printable              printable{}; // OrderExecutedWithPrice
 };
 
+static_assert(sizeof(DecodedMessage) <= 48);
+
+DecodedMessage decode(const Message &message);
+
+constexpr std::size_t MESSAGE_BLOCK_SIZE = 4096;
+
+// Headers of consecutive messages as structure of arrays, decoded in one tight pass by MessageReader::next_block().
+// The bodies point into the reader's buffer and are only valid until its next call.
+struct MessageBlock
+{
+  Message get_message(std::size_t i) const
+  {
+    return {std::span(bodies[i], lengths[i]), offsets[i]};
+  }
+
+  // Same as decode(get_message(i)), with the header taken from the arrays
+  DecodedMessage decode(std::size_t i) const;
+
+  std::size_t size{};
+  Timestamp_t max_timestamp{};
+
+  std::array<const unsigned char *, MESSAGE_BLOCK_SIZE> bodies;
+  std::array<std::uint16_t, MESSAGE_BLOCK_SIZE>         lengths;
+  std::array<std::size_t, MESSAGE_BLOCK_SIZE>           offsets;
+  std::array<MessageType, MESSAGE_BLOCK_SIZE>           types;
+  std::array<StockLocate_t, MESSAGE_BLOCK_SIZE>         locates;
+  std::array<Timestamp_t, MESSAGE_BLOCK_SIZE>           timestamps;
+};
+
+// Exact, integer accumulators of the executions of a stock since the start of the day, or within a report period with
+// per period bars, converted to decimal only when reported. A cleared bar has no trades, so the first trade of the next
+// period sets its open.
+struct Bar
+{
+  Notional_t    notional{};
+  std::uint64_t volume{};
+  std::uint64_t nr_trades{};
+  Price_t       open{};
+  Price_t       high{};
+  Price_t       low{std::numeric_limits<Price_t>::max()};
+  Price_t       close{};
+
+  void add(SharesCount_t nr_shares, Price_t price)
+  {
+    notional += static_cast<std::uint64_t>(nr_shares) * price;
+    volume += nr_shares;
+    open  = (0 == nr_trades) ? price : open;
+    high  = std::max(high, price);
+    low   = std::min(low, price);
+    close = price;
+    ++nr_trades;
+  }
+};
+
+static_assert(sizeof(Bar) <= 48);
+
+// Kept small as the order map is the largest memory consumer, no pointers into the message data
 struct OrderInfo
 {
-  Stock_t stock{};
-  Price_t price{};
+  Price_t       price{};
+  SharesCount_t nr_shares{};
+  StockLocate_t locate{};
+
+  OrderInfo() = default;
 
-  OrderInfo(Stock_t s, Price_t p) : stock(s), price(p)
+  OrderInfo(StockLocate_t l, Price_t p, SharesCount_t n) : price(p), nr_shares(n), locate(l)
   {
   }
 };
 
-class MessageHandler
+static_assert(sizeof(OrderInfo) <= 12);
+
+// Execution aggregates and symbols, indexed by stock locate. By default all report periods share one set of day to
+// date bars, with per_period each period has its own set, cleared once it reported. The bars of a locate are adjacent
+// so an execution updates them together.
+struct StockTable
+{
+  explicit StockTable(std::size_t nr_periods = 1, bool per_period = false);
+
+  // The set of bars reported for the report period at index
+  std::size_t get_bar_set(std::size_t period) const
+  {
+    return per_period ? period : 0;
+  }
+
+  Bar &get_bar(std::size_t locate, std::size_t bar_set)
+  {
+    return bars[locate * nr_bar_sets + bar_set];
+  }
+
+  const Bar &get_bar(std::size_t locate, std::size_t bar_set) const
+  {
+    return bars[locate * nr_bar_sets + bar_set];
+  }
+
+  void add(StockLocate_t locate, SharesCount_t nr_shares, Price_t price)
+  {
+    for (std::size_t bar_set = 0; bar_set < nr_bar_sets; ++bar_set)
+    {
+      auto &bar = get_bar(locate, bar_set);
+
+      if (0 == bar.nr_trades)
+      {
+        traded[bar_set].push_back(locate);
+      }
+
+      bar.add(nr_shares, price);
+    }
+
+    has_executions = true;
+  }
+
+  // Replaces a bar, e.g. merged from a shard or loaded from a snapshot
+  void set_bar(StockLocate_t locate, std::size_t bar_set, const Bar &bar);
+  // Starts the next bars of the report period at index after its report, day to date bars are kept
+  void clear(std::size_t period);
+  // Clears every bar and has_executions
+  void clear();
+
+  bool                                    per_period;
+  std::size_t                             nr_bar_sets;
+  std::vector<Bar>                        bars;
+  std::vector<std::vector<StockLocate_t>> traded;  // Locates with a bar in each set, so clear() is cheap
+  std::vector<Stock_t>                    symbols; // Filled by StockDirectory messages
+  bool                                    has_executions{};
+};
+
+// Reports are due at the first message of every period, for each of the report periods
+class ReportSchedule
 {
 public:
-  MessageHandler();
-  void handle_message(const Message &message);
+  explicit ReportSchedule(const std::vector<Timestamp_t> &periods);
+
+  bool is_due(Timestamp_t current_time) const
+  {
+    return current_time >= m_next_report_time;
+  }
+
+  // Moves every period due at current_time on to the one of current_time, calling report(index, length, time) for
+  // each with the index of the period in the report options and the boundary it reports at
+  template <typename Report>
+  void advance(Timestamp_t current_time, Report &&report)
+  {
+    for (std::size_t index = 0; index < m_periods.size(); ++index)
+    {
+      auto &period = m_periods[index];
+
+      if (current_time >= period.last_report_time + period.length)
+      {
+        period.last_report_time = (current_time / period.length) * period.length;
+        report(index, period.length, period.last_report_time);
+      }
+    }
+
+    update_next_report_time();
+  }
+
+  // Reports the periods not reported at end_time yet, e.g. at the end of a time window that isn't at a boundary,
+  // calling report(index, length, end_time) for each
+  template <typename Report>
+  void close(Timestamp_t end_time, Report &&report)
+  {
+    for (std::size_t index = 0; index < m_periods.size(); ++index)
+    {
+      auto &period = m_periods[index];
+
+      if (period.last_report_time < end_time)
+      {
+        period.last_report_time = end_time;
+        report(index, period.length, end_time);
+      }
+    }
+
+    update_next_report_time();
+  }
+
+  // The next reports are due at the periods following the ones of current_time
+  void reset(Timestamp_t current_time);
+
+  void save(std::ostream &os) const;
+  // Periods missing from the snapshot, e.g. saved by a run with other periods, restart at the latest report time.
+  // Returns the index of every saved period among the current ones, NO_PERIOD if it is no longer reported.
+  std::vector<std::size_t> load(std::istream &is);
+
+  static constexpr std::size_t NO_PERIOD = std::numeric_limits<std::size_t>::max();
 
 private:
-  void execute_order(Stock_t stock, SharesCount_t nr_shares, Price_t price);
+  struct Period
+  {
+    Timestamp_t length{};
+    Timestamp_t last_report_time{};
+  };
+
+  void update_next_report_time();
+
+  std::vector<Period> m_periods;
+  Timestamp_t         m_next_report_time{};
+};
+
+void log_system_event(Timestamp_t timestamp, SystemEventType event);
+
+constexpr unsigned MAX_VWAP_DECIMALS = 9;
+
+struct ReportOptions
+{
+  unsigned                 vwap_decimals{4};       // Up to MAX_VWAP_DECIMALS, rounded half up
+  std::vector<Timestamp_t> periods{HOUR_IN_NANOS}; // Whole seconds, ascending
+  std::vector<Stock_t>     symbols;                // Sorted, only these stocks are tracked and reported if any
+  bool                     per_period{};           // Each report holds its period only, rather than the day to date
+};
+
+// Reports are formatted and written on a background thread, the caller only copies the stocks with executions
+class ReportWriter
+{
+public:
+  explicit ReportWriter(const ReportOptions &options) : m_options(options)
+  {
+  }
+  // Writes the pending reports
+  ~ReportWriter();
+
+  ReportWriter(const ReportWriter &)            = delete;
+  ReportWriter &operator=(const ReportWriter &) = delete;
+
+  // Logs and queues the VWAP and bar of every stock with executions in the bars of the period at index, sorted by
+  // symbol, for the period ending at report_time
+  void write(const StockTable &stocks, std::size_t index, Timestamp_t period, Timestamp_t report_time,
+             Timestamp_t current_time);
+  // Waits until the queued reports are written
+  void flush();
+
+  struct Report
+  {
+    std::string                          filename;
+    std::vector<std::pair<Stock_t, Bar>> stocks;
+  };
+
+  // The whole file in one buffer, formatted with std::to_chars
+  void format(const Report &report, std::string &buffer) const;
+
+private:
+  void run();
+
+  const ReportOptions     m_options;
+  std::deque<Report>      m_reports;
+  std::mutex              m_mutex;
+  std::condition_variable m_cv;
+  std::condition_variable m_idle_cv; // Notified by the writer thread after every report
+  bool                    m_writing{};
+  bool                    m_done{};
+  std::thread             m_thread; // Started by the first report
+};
+
+// TODO Find optimum initial size
+constexpr std::size_t INITIAL_NR_ORDERS = 32 * 1024 * 1024;
+
+class HandlerStats;
+class PerfProfile;
+
+class MessageHandler
+{
+public:
+  explicit MessageHandler(std::size_t initial_nr_orders = INITIAL_NR_ORDERS, const ReportOptions &report_options = {});
+  ~MessageHandler();
+
+  // The message types process() acts on, others can be skipped by the reader
+  static constexpr MessageTypeFilter TYPE_FILTER = make_type_filter(
+      {SystemEvent, StockDirectory, AddOrder, AddOrderMPIDAttribution, OrderExecuted, OrderExecutedWithPrice,
+       OrderCancel, OrderDelete, OrderReplace, Trade});
+
+  void handle_message(const Message &message);
+  void handle(const DecodedMessage &message);
+  // Same as handling each message of the block, with the report check done once unless a report is due within it
+  void handle_block(const MessageBlock &block);
+  // Updates orders and stock aggregates only, reporting is up to the caller
+  void process(const DecodedMessage &message);
+  // Writes the report if one is due at current_time
   void report(const Timestamp_t &current_time);
+  // Restarts the aggregation at start, keeping the orders, the next report is due at the following period
+  void start_window(Timestamp_t start);
+  // Writes the reports due up to end and a last one of every period for the executions since its previous report,
+  // so a window ending between report boundaries reports its tail, with or without executions
+  void close_window(Timestamp_t end);
+
+  // Binary snapshot of the orders, the stock table and the report schedule in host byte order
+  void save(std::ostream &os) const;
+  void load(std::istream &is);
+
+  const StockTable &get_stocks() const
+  {
+    return m_stocks;
+  }
+
+  // Waits until the queued reports are written, e.g. before a checkpoint that holds them as reported
+  void flush_reports()
+  {
+    m_report_writer.flush();
+  }
 
-  using OrderMap            = HashMap<OrderReferenceNumber_t, OrderInfo>;
-  using StockVolumePriceMap = TreeMap<Stock_t, VolumePrice>;
+  // Starts the next bars of the period at index, when reported on behalf of the handler
+  void clear_period(std::size_t index)
+  {
+    m_stocks.clear(index);
+  }
 
-  OrderMap            m_orders;
-  StockVolumePriceMap m_stocks;
-  Timestamp_t         m_last_report_time{};
+  // Counts and times the processed messages by type and samples the order book from now on
+  void enable_stats();
+
+  // nullptr unless enabled
+  const HandlerStats *get_stats() const
+  {
+    return m_stats.get();
+  }
+
+  // Attributes the counts of the profile to the hour of the handled messages and to reporting, nullptr to stop
+  void set_perf_profile(PerfProfile *perf_profile)
+  {
+    m_perf_profile = perf_profile;
+  }
+
+  // Adds the processed messages and the change of the order book to counters from now on, nullptr to stop
+  void set_progress(ProgressCounters *progress);
+  // Adds the counts since the last addition, which happens by itself every ProgressCounters::MESSAGES_INTERVAL
+  void flush_progress();
+
+private:
+  void process_message(const DecodedMessage &message);
+  void execute_order(StockLocate_t locate, SharesCount_t nr_shares, Price_t price);
+  void add_stock(StockLocate_t locate, const Stock_t &stock);
+  void publish_progress();
+  // Takes executed or cancelled shares off an order, erasing it when none remain
+  void reduce_order(OrderReferenceNumber_t order_reference_number, OrderInfo &order, SharesCount_t nr_shares);
+
+#ifdef PAGED_ORDER_MAP
+  using OrderMap = PagedOrderMap<OrderReferenceNumber_t, OrderInfo>;
+#else
+  using OrderMap = HashOrderMap<OrderReferenceNumber_t, OrderInfo>;
+#endif
+
+  OrderMap       m_orders;
+  StockTable     m_stocks;
+  ReportSchedule m_report_schedule;
+  ReportWriter   m_report_writer;
+
+  const std::vector<Stock_t> m_symbols;
+  std::vector<bool>          m_tracked_locates; // Resolved from m_symbols by StockDirectory messages
+
+  std::unique_ptr<HandlerStats> m_stats;
+  PerfProfile                  *m_perf_profile{};
+  ProgressCounters             *m_progress{};
+  std::size_t                   m_nr_unpublished_messages{};
+  std::size_t                   m_published_nr_orders{};
+  Timestamp_t                   m_last_timestamp{}; // Of the last processed message, while publishing progress
 };
 
 } // namespace ITCH
@@ -0,0 +1,160 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "MessageIndex.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace ITCH
+{
+
+namespace
+{
+
+// 0 if unknown, which never matches a saved index
+std::int64_t get_file_time(const std::string &filename)
+{
+  std::error_code error;
+  const auto      time = std::filesystem::last_write_time(filename, error);
+
+  return error ? 0 : static_cast<std::int64_t>(time.time_since_epoch().count());
+}
+
+} // namespace
+
+// Host byte order, the index is a cache next to the file rather than an exchange format
+constexpr char INDEX_MAGIC[8] = {'I', 'T', 'C', 'H', 'I', 'D', 'X', '2'};
+
+struct IndexHeader
+{
+  char          magic[sizeof(INDEX_MAGIC)];
+  std::uint64_t file_size;
+  std::int64_t  file_time; // Modification time, another capture of the same size has another one
+  std::uint64_t interval;
+  std::uint64_t end;
+  std::uint64_t nr_offsets;
+};
+
+MessageIndex MessageIndex::build(const MessageReader &reader, std::size_t interval)
+{
+  if (!reader.is_mapped())
+  {
+    throw "Only memory mapped files can be indexed!";
+  }
+
+  auto index        = MessageIndex{};
+  index.m_file_size = reader.get_size();
+  index.m_interval  = interval;
+
+  auto        message   = Message{};
+  std::size_t pos       = 0;
+  std::size_t next_mark = 0;
+
+  while (reader.read(message, pos))
+  {
+    if (pos >= next_mark)
+    {
+      index.m_offsets.push_back(pos);
+      next_mark = (pos / interval + 1) * interval;
+    }
+
+    pos += MESSAGE_LENGTH_SIZE + message.get_length();
+  }
+
+  index.m_end = pos;
+  return index;
+}
+
+MessageIndex MessageIndex::load_or_build(const std::string &filename, const MessageReader &reader)
+{
+  auto index = MessageIndex{};
+
+  if (!index.load(filename, reader.get_size()))
+  {
+    std::cout << "Indexing " << filename << std::endl;
+    index = build(reader);
+    index.save(filename);
+  }
+
+  return index;
+}
+
+std::string MessageIndex::get_path(const std::string &filename)
+{
+  return filename + ".idx";
+}
+
+bool MessageIndex::load(const std::string &filename, std::size_t file_size)
+{
+  std::ifstream ifs(get_path(filename), std::ios::binary);
+  IndexHeader   header{};
+  const auto    file_time = get_file_time(filename);
+
+  if (!ifs.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      (0 != std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC))) || (header.file_size != file_size) ||
+      (0 == file_time) || (header.file_time != file_time) || (header.nr_offsets > file_size))
+  {
+    return false;
+  }
+
+  std::vector<std::uint64_t> offsets(header.nr_offsets);
+
+  if (!ifs.read(reinterpret_cast<char *>(offsets.data()), offsets.size() * sizeof(std::uint64_t)))
+  {
+    return false;
+  }
+
+  m_offsets.assign(offsets.begin(), offsets.end());
+  m_end       = header.end;
+  m_file_size = header.file_size;
+  m_interval  = header.interval;
+  return true;
+}
+
+void MessageIndex::save(const std::string &filename) const
+{
+  const auto path = get_path(filename);
+
+  IndexHeader header{};
+  std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  header.file_size  = m_file_size;
+  header.file_time  = get_file_time(filename);
+  header.interval   = m_interval;
+  header.end        = m_end;
+  header.nr_offsets = m_offsets.size();
+
+  const std::vector<std::uint64_t> offsets(m_offsets.begin(), m_offsets.end());
+
+  std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+  ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  ofs.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+
+  if (!ofs)
+  {
+    std::cerr << "Failed to write " << path << std::endl;
+  }
+}
+
+} // namespace ITCH
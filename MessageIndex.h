@@ -0,0 +1,68 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Message.h"
+#include <string>
+#include <vector>
+
+namespace ITCH
+{
+
+// Message boundaries at regular intervals of a memory mapped file, so it can be cut into chunks to be decoded
+// concurrently, or read starting mid-file. Persisted next to the file as "<file>.idx".
+class MessageIndex
+{
+public:
+  static constexpr std::size_t DEFAULT_INTERVAL = 64 * 1024 * 1024;
+
+  // Walks the message lengths of the whole file, recording the first boundary at or after every interval
+  static MessageIndex build(const MessageReader &reader, std::size_t interval = DEFAULT_INTERVAL);
+  // Loads the index of filename if it matches the file, builds and saves it otherwise
+  static MessageIndex load_or_build(const std::string &filename, const MessageReader &reader);
+
+  static std::string get_path(const std::string &filename);
+
+  // The index of filename, false unless it was built from a file of the same size and modification time
+  bool load(const std::string &filename, std::size_t file_size);
+  void save(const std::string &filename) const;
+
+  std::size_t get_nr_chunks() const
+  {
+    return m_offsets.size();
+  }
+
+  // [begin, end) of chunk i, the last one ends after the last complete message
+  std::pair<std::size_t, std::size_t> get_chunk(std::size_t i) const
+  {
+    return {m_offsets[i], (i + 1 < m_offsets.size()) ? m_offsets[i + 1] : m_end};
+  }
+
+private:
+  std::vector<std::size_t> m_offsets;
+  std::size_t              m_end{};
+  std::size_t              m_file_size{};
+  std::size_t              m_interval{};
+};
+
+} // namespace ITCH
@@ -0,0 +1,354 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ITCH
+{
+
+// A field of a message at OFFSET bytes from its type, big endian integer or left justified, space padded alpha
+template <std::size_t OFFSET_, std::size_t SIZE_, bool ALPHA_ = false> struct Field
+{
+  static constexpr std::size_t OFFSET = OFFSET_;
+  static constexpr std::size_t SIZE   = SIZE_;
+  static constexpr std::size_t END    = OFFSET_ + SIZE_;
+  static constexpr bool        ALPHA  = ALPHA_;
+};
+
+template <std::size_t OFFSET, std::size_t SIZE> using Integer = Field<OFFSET, SIZE>;
+template <std::size_t OFFSET, std::size_t SIZE> using Alpha   = Field<OFFSET, SIZE, true>;
+
+struct HeaderLayout
+{
+  using Type           = Alpha<0, 1>;
+  using StockLocate    = Integer<1, 2>;
+  using TrackingNumber = Integer<3, 2>;
+  using Timestamp      = Integer<5, 6>;
+};
+
+// Length of a message with the header and Fields, 0 unless each field starts where the previous one ends
+template <typename... Fields> constexpr std::size_t message_length()
+{
+  std::size_t end        = 0;
+  bool        contiguous = true;
+
+  ((contiguous = contiguous && (Fields::OFFSET == end), end = Fields::END), ...);
+  return contiguous ? end : 0;
+}
+
+template <typename... Fields> constexpr std::size_t layout_length()
+{
+  return message_length<HeaderLayout::Type, HeaderLayout::StockLocate, HeaderLayout::TrackingNumber,
+                        HeaderLayout::Timestamp, Fields...>();
+}
+
+// Layouts of the NASDAQ TotalView-ITCH 5.0 messages
+
+struct SystemEventLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'S';
+  using EventCode              = Alpha<11, 1>;
+  static constexpr auto LENGTH = layout_length<EventCode>();
+};
+
+struct StockDirectoryLayout : HeaderLayout
+{
+  static constexpr char TYPE        = 'R';
+  using Stock                       = Alpha<11, 8>;
+  using MarketCategory              = Alpha<19, 1>;
+  using FinancialStatusIndicator    = Alpha<20, 1>;
+  using RoundLotSize                = Integer<21, 4>;
+  using RoundLotsOnly               = Alpha<25, 1>;
+  using IssueClassification         = Alpha<26, 1>;
+  using IssueSubType                = Alpha<27, 2>;
+  using Authenticity                = Alpha<29, 1>;
+  using ShortSaleThresholdIndicator = Alpha<30, 1>;
+  using IPOFlag                     = Alpha<31, 1>;
+  using LULDReferencePriceTier      = Alpha<32, 1>;
+  using ETPFlag                     = Alpha<33, 1>;
+  using ETPLeverageFactor           = Integer<34, 4>;
+  using InverseIndicator            = Alpha<38, 1>;
+  static constexpr auto LENGTH      =
+      layout_length<Stock, MarketCategory, FinancialStatusIndicator, RoundLotSize, RoundLotsOnly, IssueClassification,
+                    IssueSubType, Authenticity, ShortSaleThresholdIndicator, IPOFlag, LULDReferencePriceTier, ETPFlag,
+                    ETPLeverageFactor, InverseIndicator>();
+};
+
+struct StockTradingActionLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'H';
+  using Stock                  = Alpha<11, 8>;
+  using TradingState           = Alpha<19, 1>;
+  using Reserved               = Alpha<20, 1>;
+  using Reason                 = Alpha<21, 4>;
+  static constexpr auto LENGTH = layout_length<Stock, TradingState, Reserved, Reason>();
+};
+
+struct RegSHORestrictionLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'Y';
+  using Stock                  = Alpha<11, 8>;
+  using RegSHOAction           = Alpha<19, 1>;
+  static constexpr auto LENGTH = layout_length<Stock, RegSHOAction>();
+};
+
+struct MarketParticipantPositionLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'L';
+  using MPID                   = Alpha<11, 4>;
+  using Stock                  = Alpha<15, 8>;
+  using PrimaryMarketMaker     = Alpha<23, 1>;
+  using MarketMakerMode        = Alpha<24, 1>;
+  using ParticipantState       = Alpha<25, 1>;
+  static constexpr auto LENGTH = layout_length<MPID, Stock, PrimaryMarketMaker, MarketMakerMode, ParticipantState>();
+};
+
+struct MWCBDeclineLevelLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'V';
+  using Level1                 = Integer<11, 8>; // Price(8)
+  using Level2                 = Integer<19, 8>;
+  using Level3                 = Integer<27, 8>;
+  static constexpr auto LENGTH = layout_length<Level1, Level2, Level3>();
+};
+
+struct MWCBStatusLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'W';
+  using BreachedLevel          = Alpha<11, 1>;
+  static constexpr auto LENGTH = layout_length<BreachedLevel>();
+};
+
+struct IPOQuotingPeriodUpdateLayout : HeaderLayout
+{
+  static constexpr char TYPE         = 'K';
+  using Stock                        = Alpha<11, 8>;
+  using IPOQuotationReleaseTime      = Integer<19, 4>;
+  using IPOQuotationReleaseQualifier = Alpha<23, 1>;
+  using IPOPrice                     = Integer<24, 4>;
+  static constexpr auto LENGTH       =
+      layout_length<Stock, IPOQuotationReleaseTime, IPOQuotationReleaseQualifier, IPOPrice>();
+};
+
+struct LULDAuctionCollarLayout : HeaderLayout
+{
+  static constexpr char TYPE        = 'J';
+  using Stock                       = Alpha<11, 8>;
+  using AuctionCollarReferencePrice = Integer<19, 4>;
+  using UpperAuctionCollarPrice     = Integer<23, 4>;
+  using LowerAuctionCollarPrice     = Integer<27, 4>;
+  using AuctionCollarExtension      = Integer<31, 4>;
+  static constexpr auto LENGTH      =
+      layout_length<Stock, AuctionCollarReferencePrice, UpperAuctionCollarPrice, LowerAuctionCollarPrice,
+                    AuctionCollarExtension>();
+};
+
+struct OperationalHaltLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'h';
+  using Stock                  = Alpha<11, 8>;
+  using MarketCode             = Alpha<19, 1>;
+  using OperationalHaltAction  = Alpha<20, 1>;
+  static constexpr auto LENGTH = layout_length<Stock, MarketCode, OperationalHaltAction>();
+};
+
+struct AddOrderLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'A';
+  using OrderReferenceNumber   = Integer<11, 8>;
+  using BuySellIndicator       = Alpha<19, 1>;
+  using Shares                 = Integer<20, 4>;
+  using Stock                  = Alpha<24, 8>;
+  using Price                  = Integer<32, 4>;
+  static constexpr auto LENGTH = layout_length<OrderReferenceNumber, BuySellIndicator, Shares, Stock, Price>();
+};
+
+struct AddOrderMPIDAttributionLayout : AddOrderLayout
+{
+  static constexpr char TYPE   = 'F';
+  using Attribution            = Alpha<36, 4>;
+  static constexpr auto LENGTH =
+      layout_length<OrderReferenceNumber, BuySellIndicator, Shares, Stock, Price, Attribution>();
+};
+
+struct OrderExecutedLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'E';
+  using OrderReferenceNumber   = Integer<11, 8>;
+  using ExecutedShares         = Integer<19, 4>;
+  using MatchNumber            = Integer<23, 8>;
+  static constexpr auto LENGTH = layout_length<OrderReferenceNumber, ExecutedShares, MatchNumber>();
+};
+
+struct OrderExecutedWithPriceLayout : OrderExecutedLayout
+{
+  static constexpr char TYPE   = 'C';
+  using Printable              = Alpha<31, 1>;
+  using ExecutionPrice         = Integer<32, 4>;
+  static constexpr auto LENGTH =
+      layout_length<OrderReferenceNumber, ExecutedShares, MatchNumber, Printable, ExecutionPrice>();
+};
+
+struct OrderCancelLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'X';
+  using OrderReferenceNumber   = Integer<11, 8>;
+  using CancelledShares        = Integer<19, 4>;
+  static constexpr auto LENGTH = layout_length<OrderReferenceNumber, CancelledShares>();
+};
+
+struct OrderDeleteLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'D';
+  using OrderReferenceNumber   = Integer<11, 8>;
+  static constexpr auto LENGTH = layout_length<OrderReferenceNumber>();
+};
+
+struct OrderReplaceLayout : HeaderLayout
+{
+  static constexpr char TYPE         = 'U';
+  using OriginalOrderReferenceNumber = Integer<11, 8>;
+  using NewOrderReferenceNumber      = Integer<19, 8>;
+  using Shares                       = Integer<27, 4>;
+  using Price                        = Integer<31, 4>;
+  static constexpr auto LENGTH       =
+      layout_length<OriginalOrderReferenceNumber, NewOrderReferenceNumber, Shares, Price>();
+};
+
+struct TradeLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'P';
+  using OrderReferenceNumber   = Integer<11, 8>;
+  using BuySellIndicator       = Alpha<19, 1>;
+  using Shares                 = Integer<20, 4>;
+  using Stock                  = Alpha<24, 8>;
+  using Price                  = Integer<32, 4>;
+  using MatchNumber            = Integer<36, 8>;
+  static constexpr auto LENGTH =
+      layout_length<OrderReferenceNumber, BuySellIndicator, Shares, Stock, Price, MatchNumber>();
+};
+
+struct CrossTradeLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'Q';
+  using Shares                 = Integer<11, 8>;
+  using Stock                  = Alpha<19, 8>;
+  using CrossPrice             = Integer<27, 4>;
+  using MatchNumber            = Integer<31, 8>;
+  using CrossType              = Alpha<39, 1>;
+  static constexpr auto LENGTH = layout_length<Shares, Stock, CrossPrice, MatchNumber, CrossType>();
+};
+
+struct BrokenTradeLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'B';
+  using MatchNumber            = Integer<11, 8>;
+  static constexpr auto LENGTH = layout_length<MatchNumber>();
+};
+
+struct NetOrderImbalanceIndicatorLayout : HeaderLayout
+{
+  static constexpr char TYPE    = 'I';
+  using PairedShares            = Integer<11, 8>;
+  using ImbalanceShares         = Integer<19, 8>;
+  using ImbalanceDirection      = Alpha<27, 1>;
+  using Stock                   = Alpha<28, 8>;
+  using FarPrice                = Integer<36, 4>;
+  using NearPrice               = Integer<40, 4>;
+  using CurrentReferencePrice   = Integer<44, 4>;
+  using CrossType               = Alpha<48, 1>;
+  using PriceVariationIndicator = Alpha<49, 1>;
+  static constexpr auto LENGTH  =
+      layout_length<PairedShares, ImbalanceShares, ImbalanceDirection, Stock, FarPrice, NearPrice,
+                    CurrentReferencePrice, CrossType, PriceVariationIndicator>();
+};
+
+struct RetailInterestLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'N';
+  using Stock                  = Alpha<11, 8>;
+  using InterestFlag           = Alpha<19, 1>;
+  static constexpr auto LENGTH = layout_length<Stock, InterestFlag>();
+};
+
+struct DirectListingWithCapitalRaisePriceDiscoveryLayout : HeaderLayout
+{
+  static constexpr char TYPE   = 'O';
+  using Stock                  = Alpha<11, 8>;
+  using OpenEligibilityStatus  = Alpha<19, 1>;
+  using MinimumAllowablePrice  = Integer<20, 4>;
+  using MaximumAllowablePrice  = Integer<24, 4>;
+  using NearExecutionPrice     = Integer<28, 4>;
+  using NearExecutionTime      = Integer<32, 8>;
+  using LowerPriceRangeCollar  = Integer<40, 4>;
+  using UpperPriceRangeCollar  = Integer<44, 4>;
+  static constexpr auto LENGTH =
+      layout_length<Stock, OpenEligibilityStatus, MinimumAllowablePrice, MaximumAllowablePrice, NearExecutionPrice,
+                    NearExecutionTime, LowerPriceRangeCollar, UpperPriceRangeCollar>();
+};
+
+template <typename... Layouts> constexpr std::array<std::uint16_t, 256> make_length_table()
+{
+  std::array<std::uint16_t, 256> lengths{};
+  ((lengths[static_cast<unsigned char>(Layouts::TYPE)] = Layouts::LENGTH), ...);
+  return lengths;
+}
+
+// Message length by type, 0 for unknown types
+constexpr auto MESSAGE_LENGTHS = make_length_table<
+    SystemEventLayout, StockDirectoryLayout, StockTradingActionLayout, RegSHORestrictionLayout,
+    MarketParticipantPositionLayout, MWCBDeclineLevelLayout, MWCBStatusLayout, IPOQuotingPeriodUpdateLayout,
+    LULDAuctionCollarLayout, OperationalHaltLayout, AddOrderLayout, AddOrderMPIDAttributionLayout, OrderExecutedLayout,
+    OrderExecutedWithPriceLayout, OrderCancelLayout, OrderDeleteLayout, OrderReplaceLayout, TradeLayout,
+    CrossTradeLayout, BrokenTradeLayout, NetOrderImbalanceIndicatorLayout, RetailInterestLayout,
+    DirectListingWithCapitalRaisePriceDiscoveryLayout>();
+
+// Lengths given by the specification, a gap or overlap between fields yields 0
+static_assert(MESSAGE_LENGTHS['S'] == 12);
+static_assert(MESSAGE_LENGTHS['R'] == 39);
+static_assert(MESSAGE_LENGTHS['H'] == 25);
+static_assert(MESSAGE_LENGTHS['Y'] == 20);
+static_assert(MESSAGE_LENGTHS['L'] == 26);
+static_assert(MESSAGE_LENGTHS['V'] == 35);
+static_assert(MESSAGE_LENGTHS['W'] == 12);
+static_assert(MESSAGE_LENGTHS['K'] == 28);
+static_assert(MESSAGE_LENGTHS['J'] == 35);
+static_assert(MESSAGE_LENGTHS['h'] == 21);
+static_assert(MESSAGE_LENGTHS['A'] == 36);
+static_assert(MESSAGE_LENGTHS['F'] == 40);
+static_assert(MESSAGE_LENGTHS['E'] == 31);
+static_assert(MESSAGE_LENGTHS['C'] == 36);
+static_assert(MESSAGE_LENGTHS['X'] == 23);
+static_assert(MESSAGE_LENGTHS['D'] == 19);
+static_assert(MESSAGE_LENGTHS['U'] == 35);
+static_assert(MESSAGE_LENGTHS['P'] == 44);
+static_assert(MESSAGE_LENGTHS['Q'] == 40);
+static_assert(MESSAGE_LENGTHS['B'] == 19);
+static_assert(MESSAGE_LENGTHS['I'] == 50);
+static_assert(MESSAGE_LENGTHS['N'] == 20);
+static_assert(MESSAGE_LENGTHS['O'] == 48);
+
+} // namespace ITCH
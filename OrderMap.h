@@ -0,0 +1,347 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ankerl/unordered_dense.h"
+#include <array>
+#include <bit>
+#include <boost/container/flat_map.hpp>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ITCH
+{
+
+// Compared with the alternatives below and the standard maps by BM_OrderMap in Benchmark.cpp
+template <typename K, typename V> using HashMap = ankerl::unordered_dense::map<K, V>;
+// template <typename K, typename V> using HashMap = ankerl::unordered_dense::segmented_map<K, V>;
+// template <typename K, typename V> using HashMap = boost::unordered_map<K, V>;
+// TODO Segfaulting at key comparison during erase!? Fixable?
+// template <typename K, typename V> using HashMap = btree::map<K, V>;
+// template <typename K, typename V> using TreeMap = boost::container::map<K, V>;
+template <typename K, typename V> using TreeMap = boost::container::flat_map<K, V>;
+
+// Order maps share a minimal interface: find() returns a pointer to the value or nullptr, extract() moves a value
+// out and erases it with a single lookup. Map can be any other associative container for comparison, e.g. TreeMap.
+template <typename K, typename V, typename Map = HashMap<K, V>> class HashOrderMap
+{
+public:
+  void reserve(std::size_t size)
+  {
+    if constexpr (requires { m_map.reserve(size); })
+    {
+      m_map.reserve(size);
+    }
+  }
+
+  std::size_t size() const
+  {
+    return m_map.size();
+  }
+
+  // Number of slots, size() / capacity() is the load factor
+  std::size_t capacity() const
+  {
+    return m_map.bucket_count();
+  }
+
+  bool empty() const
+  {
+    return m_map.empty();
+  }
+
+  V *find(K key)
+  {
+    const auto iter = m_map.find(key);
+    return (m_map.end() == iter) ? nullptr : &iter->second;
+  }
+
+  template <typename... Args> void try_emplace(K key, Args &&...args)
+  {
+    m_map.try_emplace(key, std::forward<Args>(args)...);
+  }
+
+  bool extract(K key, V &value)
+  {
+    const auto iter = m_map.find(key);
+
+    if (m_map.end() == iter)
+    {
+      return false;
+    }
+
+    value = iter->second;
+    m_map.erase(iter);
+    return true;
+  }
+
+  void erase(K key)
+  {
+    m_map.erase(key);
+  }
+
+  template <typename F> void for_each(F &&f) const
+  {
+    for (const auto &[key, value] : m_map)
+    {
+      f(key, value);
+    }
+  }
+
+private:
+  Map m_map;
+};
+
+// Direct indexed order map, ITCH order reference numbers are assigned nearly sequentially during the day.
+// Keys are split into pages of 2^PAGE_BITS slots relative to the first key inserted, so a lookup is a shift and an
+// index without hashing. A page is freed once all its orders are deleted; an old page that only keeps a few
+// long-living orders moves them to the overflow hash map, which also holds keys outside of the paged range.
+template <typename K, typename V, unsigned PAGE_BITS = 12> class PagedOrderMap
+{
+public:
+  void reserve(std::size_t size)
+  {
+    m_pages.reserve(size >> PAGE_BITS);
+  }
+
+  std::size_t size() const
+  {
+    return m_size + m_overflow.size();
+  }
+
+  std::size_t capacity() const
+  {
+    return m_nr_pages * PAGE_SIZE + m_overflow.capacity();
+  }
+
+  V *find(K key)
+  {
+    const auto index = page_index(key);
+
+    if (index < m_pages.size())
+    {
+      const auto *page = m_pages[index].get();
+      const auto  slot = key & SLOT_MASK;
+
+      if (page && page->is_used(slot))
+      {
+        return &m_pages[index]->values[slot];
+      }
+    }
+
+    return m_overflow.empty() ? nullptr : m_overflow.find(key);
+  }
+
+  template <typename... Args> void try_emplace(K key, Args &&...args)
+  {
+    if (!m_has_base)
+    {
+      m_base     = key & ~SLOT_MASK;
+      m_has_base = true;
+    }
+
+    const auto index = page_index(key);
+
+    if (index >= MAX_PAGES)
+    {
+      m_overflow.try_emplace(key, std::forward<Args>(args)...);
+      return;
+    }
+
+    if (index >= m_pages.size())
+    {
+      m_pages.resize(index + 1);
+    }
+
+    auto &page = m_pages[index];
+
+    if (!page)
+    {
+      page = allocate_page();
+      ++m_nr_pages;
+
+      // The newest pages moved on, an older one might be left with only a few orders
+      if (index >= EVICTION_DISTANCE)
+      {
+        try_evict_page(index - EVICTION_DISTANCE);
+      }
+    }
+
+    const auto slot = key & SLOT_MASK;
+
+    if (!page->is_used(slot))
+    {
+      page->values[slot] = V(std::forward<Args>(args)...);
+      page->used[slot / 64] |= std::uint64_t{1} << (slot % 64);
+      ++page->nr_used;
+      ++m_size;
+    }
+  }
+
+  bool extract(K key, V &value)
+  {
+    const auto index = page_index(key);
+
+    if (index < m_pages.size())
+    {
+      const auto slot = key & SLOT_MASK;
+
+      if (m_pages[index] && m_pages[index]->is_used(slot))
+      {
+        value = m_pages[index]->values[slot];
+        erase_slot(index, slot);
+        return true;
+      }
+    }
+
+    return !m_overflow.empty() && m_overflow.extract(key, value);
+  }
+
+  void erase(K key)
+  {
+    const auto index = page_index(key);
+
+    if (index < m_pages.size())
+    {
+      const auto slot = key & SLOT_MASK;
+
+      if (m_pages[index] && m_pages[index]->is_used(slot))
+      {
+        erase_slot(index, slot);
+        return;
+      }
+    }
+
+    if (!m_overflow.empty())
+    {
+      m_overflow.erase(key);
+    }
+  }
+
+  template <typename F> void for_each(F &&f) const
+  {
+    for (std::size_t index = 0; index < m_pages.size(); ++index)
+    {
+      if (const auto *page = m_pages[index].get())
+      {
+        for_each_used(*page, [&](K slot) { f(m_base + (index << PAGE_BITS) + slot, page->values[slot]); });
+      }
+    }
+
+    m_overflow.for_each(f);
+  }
+
+private:
+  static constexpr std::size_t PAGE_SIZE = std::size_t{1} << PAGE_BITS;
+  static constexpr K           SLOT_MASK = PAGE_SIZE - 1;
+  // Keys beyond 2^(PAGE_BITS + 20) orders from the base go to the overflow map, bounding the page table
+  static constexpr std::size_t MAX_PAGES = std::size_t{1} << 20;
+  // Pages within this distance of the newest one are still receiving orders and are never evicted
+  static constexpr std::size_t EVICTION_DISTANCE = 16;
+  // Pages behind it are evicted once this few orders are left
+  static constexpr std::uint32_t EVICTION_NR_USED = PAGE_SIZE / 32;
+
+  struct Page
+  {
+    std::array<std::uint64_t, PAGE_SIZE / 64> used{};
+    std::uint32_t                             nr_used{};
+    std::array<V, PAGE_SIZE>                  values;
+
+    bool is_used(K slot) const
+    {
+      return used[slot / 64] & (std::uint64_t{1} << (slot % 64));
+    }
+  };
+
+  template <typename F> static void for_each_used(const Page &page, F &&f)
+  {
+    for (std::size_t word = 0; word < page.used.size(); ++word)
+    {
+      for (auto bits = page.used[word]; bits; bits &= bits - 1)
+      {
+        f(static_cast<K>(word * 64 + std::countr_zero(bits)));
+      }
+    }
+  }
+
+  // Keys below the base wrap around to a page index beyond MAX_PAGES
+  std::size_t page_index(K key) const
+  {
+    return static_cast<std::size_t>((key - m_base) >> PAGE_BITS);
+  }
+
+  std::unique_ptr<Page> allocate_page()
+  {
+    if (m_spare_page)
+    {
+      m_spare_page->used.fill(0);
+      m_spare_page->nr_used = 0;
+      return std::move(m_spare_page);
+    }
+
+    return std::make_unique<Page>();
+  }
+
+  void erase_slot(std::size_t index, K slot)
+  {
+    auto &page = m_pages[index];
+
+    page->used[slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+    --page->nr_used;
+    --m_size;
+
+    if (index + EVICTION_DISTANCE < m_pages.size())
+    {
+      try_evict_page(index);
+    }
+  }
+
+  void try_evict_page(std::size_t index)
+  {
+    auto &page = m_pages[index];
+
+    if (!page || (page->nr_used > EVICTION_NR_USED))
+    {
+      return;
+    }
+
+    for_each_used(*page,
+                  [&](K slot) { m_overflow.try_emplace(m_base + (index << PAGE_BITS) + slot, page->values[slot]); });
+
+    m_size -= page->nr_used;
+    m_spare_page = std::move(page);
+    --m_nr_pages;
+  }
+
+  std::vector<std::unique_ptr<Page>> m_pages;
+  std::unique_ptr<Page>              m_spare_page;
+  HashOrderMap<K, V>                 m_overflow;
+  K                                  m_base{};
+  bool                               m_has_base{};
+  std::size_t                        m_size{};
+  std::size_t                        m_nr_pages{}; // Allocated in m_pages
+};
+
+} // namespace ITCH
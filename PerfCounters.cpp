@@ -0,0 +1,214 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "PerfCounters.h"
+#include <algorithm>
+#include <charconv>
+#include <iomanip>
+#include <ostream>
+#include <string_view>
+
+#if defined(COMPILER_SUPPORTS_PERF_EVENT_OPEN)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ITCH
+{
+
+PerfCounters::PerfCounters()
+{
+  m_fds.fill(-1);
+
+#if defined(COMPILER_SUPPORTS_PERF_EVENT_OPEN)
+  constexpr std::array<std::uint32_t, NR_EVENTS> types{PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                                       PERF_TYPE_SOFTWARE};
+  constexpr std::array<std::uint64_t, NR_EVENTS> configs{PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+                                                         PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_SW_PAGE_FAULTS};
+
+  for (std::size_t event = 0; event < NR_EVENTS; ++event)
+  {
+    perf_event_attr attr{};
+    attr.size           = sizeof(attr);
+    attr.type           = types[event];
+    attr.config         = configs[event];
+    attr.exclude_kernel = 1; // Allowed with the default perf_event_paranoid of 2
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // This thread on any CPU, counting from now on
+    m_fds[event] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(COMPILER_SUPPORTS_PERF_EVENT_OPEN)
+  for (const auto fd : m_fds)
+  {
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+  }
+#endif
+}
+
+PerfCounters::Values PerfCounters::read() const
+{
+  Values values{};
+
+#if defined(COMPILER_SUPPORTS_PERF_EVENT_OPEN)
+  for (std::size_t event = 0; event < NR_EVENTS; ++event)
+  {
+    // Laid out as the read_format asks for
+    std::array<std::uint64_t, 3> fields{};
+
+    if ((m_fds[event] >= 0) && (::read(m_fds[event], fields.data(), sizeof(fields)) == sizeof(fields)))
+    {
+      values[event] = {fields[0], fields[1], fields[2]};
+    }
+  }
+#endif
+
+  return values;
+}
+
+bool PerfProfile::is_open() const
+{
+  for (std::size_t event = 0; event < PerfCounters::NR_EVENTS; ++event)
+  {
+    if (m_counters.is_open(event))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void PerfProfile::accumulate()
+{
+  const auto values = m_counters.read();
+
+  for (std::size_t event = 0; event < PerfCounters::NR_EVENTS; ++event)
+  {
+    const auto delta = values[event] - m_last[event];
+
+    m_phases[m_phase][event] += delta;
+
+    if (m_hour < NR_HOURS)
+    {
+      m_hours[m_hour][event] += delta;
+    }
+  }
+
+  m_last = values;
+}
+
+void PerfProfile::set_phase(Phase phase)
+{
+  accumulate();
+  m_phase = phase;
+}
+
+void PerfProfile::start_hour(Timestamp_t timestamp)
+{
+  accumulate();
+  m_hour               = std::min<std::size_t>(timestamp / HOUR_IN_NANOS, NR_HOURS - 1);
+  m_seen_hours[m_hour] = true;
+  m_next_hour          = (timestamp / HOUR_IN_NANOS + 1) * HOUR_IN_NANOS;
+}
+
+void PerfProfile::print(std::ostream &os)
+{
+  accumulate();
+
+  const auto print_values = [&](const PerfCounters::Values &values) {
+    for (std::size_t event = 0; event < PerfCounters::NR_EVENTS; ++event)
+    {
+      os << " | ";
+
+      const auto &value = values[event];
+
+      if (!m_counters.is_open(event) || (value.time_enabled && !value.time_running))
+      {
+        // Not counted at all while multiplexed, nothing to scale
+        os << "n/a";
+      }
+      else if (value.time_running == value.time_enabled)
+      {
+        os << value.count;
+      }
+      else
+      {
+        // Scaled up from the time the event was running, with the factor
+        const auto scale = static_cast<double>(value.time_enabled) / static_cast<double>(value.time_running);
+        std::array<char, 32> factor{};
+        const auto          *end =
+            std::to_chars(factor.data(), factor.data() + factor.size(), scale, std::chars_format::fixed, 2).ptr;
+
+        os << static_cast<std::uint64_t>(static_cast<double>(value.count) * scale) << " (x"
+           << std::string_view(factor.data(), static_cast<std::size_t>(end - factor.data())) << ")";
+      }
+    }
+
+    os << std::endl;
+  };
+
+  const auto print_header = [&](const char *name) {
+    os << "Perf | " << name;
+
+    for (const auto *event : PerfCounters::NAMES)
+    {
+      os << " | " << event;
+    }
+
+    os << std::endl;
+  };
+
+  constexpr std::array<const char *, NR_PHASES> phase_names{"Mapping", "Parsing", "Reporting"};
+
+  print_header("Phase");
+
+  for (std::size_t phase = 0; phase < NR_PHASES; ++phase)
+  {
+    os << "Perf | " << phase_names[phase];
+    print_values(m_phases[phase]);
+  }
+
+  print_header("Hour");
+
+  for (std::size_t hour = 0; hour < NR_HOURS; ++hour)
+  {
+    if (m_seen_hours[hour])
+    {
+      os << "Perf | " << std::setfill('0') << std::setw(2) << hour << std::setfill(' ');
+      print_values(m_hours[hour]);
+    }
+  }
+}
+
+} // namespace ITCH
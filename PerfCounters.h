@@ -0,0 +1,130 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Message.h"
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+
+namespace ITCH
+{
+
+// Hardware and software event counters of the calling thread, opened with perf_event_open(2) on Linux. Events the
+// kernel or the machine doesn't provide, e.g. hardware events in most virtual machines, are left out.
+class PerfCounters
+{
+public:
+  static constexpr std::size_t NR_EVENTS = 4;
+  static constexpr std::array<const char *, NR_EVENTS> NAMES{"Instructions", "Cache misses", "Branch misses",
+                                                             "Page faults"};
+
+  // When there are more events than hardware counters the kernel multiplexes them, an event only counts while it is
+  // running, the count scaled by enabled / running estimates the full one
+  struct Value
+  {
+    std::uint64_t count{};
+    std::uint64_t time_enabled{};
+    std::uint64_t time_running{};
+
+    Value &operator+=(const Value &other)
+    {
+      count += other.count;
+      time_enabled += other.time_enabled;
+      time_running += other.time_running;
+      return *this;
+    }
+
+    Value operator-(const Value &other) const
+    {
+      return {count - other.count, time_enabled - other.time_enabled, time_running - other.time_running};
+    }
+  };
+
+  using Values = std::array<Value, NR_EVENTS>;
+
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters &)            = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool is_open(std::size_t event) const
+  {
+    return m_fds[event] >= 0;
+  }
+
+  // Counts since the counters were opened, 0 for events that aren't open
+  Values read() const;
+
+private:
+  std::array<int, NR_EVENTS> m_fds;
+};
+
+// Splits the counts of the thread running the handler by phase of the run and by hour of market time
+class PerfProfile
+{
+public:
+  enum Phase
+  {
+    Mapping,
+    Parsing,
+    Reporting,
+    NR_PHASES
+  };
+
+  bool is_open() const;
+
+  // The counts up to now belong to the previous phase, Mapping at first
+  void set_phase(Phase phase);
+
+  // The counts up to now belong to the previous hour once timestamp is in the next one
+  void set_time(Timestamp_t timestamp)
+  {
+    if (timestamp >= m_next_hour)
+    {
+      start_hour(timestamp);
+    }
+  }
+
+  // Summary lines starting with "Perf |"
+  void print(std::ostream &os);
+
+private:
+  static constexpr std::size_t NR_HOURS = 24;
+
+  void start_hour(Timestamp_t timestamp);
+  void accumulate();
+
+  PerfCounters                                m_counters;
+  PerfCounters::Values                        m_last{};
+  std::array<PerfCounters::Values, NR_PHASES> m_phases{};
+  std::array<PerfCounters::Values, NR_HOURS>  m_hours{};
+  std::array<bool, NR_HOURS>                  m_seen_hours{};
+  Phase                                       m_phase{Mapping};
+  std::size_t                                 m_hour{NR_HOURS}; // None before the first message
+  Timestamp_t                                 m_next_hour{};
+};
+
+} // namespace ITCH
@@ -0,0 +1,183 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Message.h"
+#include "MessageIndex.h"
+#include "SpscQueue.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace ITCH
+{
+
+struct DecodedBatch
+{
+  static constexpr std::size_t CAPACITY = 1024;
+
+  std::array<DecodedMessage, CAPACITY> messages;
+  std::size_t                          size{};
+  bool                                 last{};
+};
+
+constexpr std::size_t PIPELINE_QUEUE_SIZE = 16; // Batches in flight, ~750KB of decoded messages
+
+// Walks the message boundaries and decodes on background threads, handing batches of decoded messages through
+// lock-free SPSC queues to handler.handle() on the calling thread. With an index, the chunks of the file are decoded
+// by nr_decoders threads round-robin, each with its own queue, and handled in file order.
+template <typename Handler>
+void run_pipelined(MessageReader &reader, Handler &handler, const MessageIndex *index = nullptr,
+                   std::size_t nr_decoders = 1)
+{
+  const auto nr_chunks = index ? index->get_nr_chunks() : 1;
+  nr_decoders          = std::max<std::size_t>(1, std::min(nr_decoders, nr_chunks));
+
+  std::vector<std::unique_ptr<SpscQueue<DecodedBatch>>> queues;
+  std::vector<std::thread>                              decoders;
+  std::vector<std::exception_ptr>                       decoder_errors(nr_decoders);
+  std::atomic<bool>                                     stop{}; // Set by either side when it bails out
+
+  // The last batch of every chunk is flagged
+  const auto decode_chunk = [&stop](MessageReader &chunk_reader, SpscQueue<DecodedBatch> &queue) {
+    auto message = Message{};
+
+    for (bool last = false; !last;)
+    {
+      auto *batch = queue.wait_produce(stop);
+
+      if (!batch)
+      {
+        return;
+      }
+
+      for (batch->size = 0; batch->size < DecodedBatch::CAPACITY; ++batch->size)
+      {
+        if (!chunk_reader.next(message))
+        {
+          last = true;
+          break;
+        }
+
+        batch->messages[batch->size] = decode(message);
+      }
+
+      batch->last = last;
+      queue.produce();
+    }
+  };
+
+  const auto join = [&decoders] {
+    for (auto &decoder : decoders)
+    {
+      decoder.join();
+    }
+  };
+
+  for (std::size_t i = 0; i < nr_decoders; ++i)
+  {
+    queues.push_back(std::make_unique<SpscQueue<DecodedBatch>>(PIPELINE_QUEUE_SIZE));
+  }
+
+  for (std::size_t i = 0; i < nr_decoders; ++i)
+  {
+    decoders.emplace_back([&, i] {
+      try
+      {
+        if (!index)
+        {
+          decode_chunk(reader, *queues[i]);
+          return;
+        }
+
+        for (auto chunk = i; chunk < nr_chunks; chunk += nr_decoders)
+        {
+          const auto [begin, end] = index->get_chunk(chunk);
+          auto chunk_reader       = MessageReader{reader, begin, end};
+          decode_chunk(chunk_reader, *queues[i]);
+        }
+      }
+      catch (...)
+      {
+        decoder_errors[i] = std::current_exception();
+        stop              = true;
+      }
+    });
+  }
+
+  // False once a failed decoder stopped the pipeline, after draining its queue
+  const auto handle_chunk = [&](SpscQueue<DecodedBatch> &queue) {
+    for (bool last = false; !last;)
+    {
+      const auto *batch = queue.wait_consume(stop);
+
+      if (!batch)
+      {
+        return false;
+      }
+
+      for (std::size_t i = 0; i < batch->size; ++i)
+      {
+        handler.handle(batch->messages[i]);
+      }
+
+      last = batch->last;
+      queue.consume();
+    }
+
+    return true;
+  };
+
+  try
+  {
+    for (std::size_t chunk = 0; chunk < nr_chunks; ++chunk)
+    {
+      if (!handle_chunk(*queues[chunk % nr_decoders]))
+      {
+        break;
+      }
+    }
+  }
+  catch (...)
+  {
+    stop = true;
+    join();
+    throw;
+  }
+
+  join();
+
+  for (const auto &error : decoder_errors)
+  {
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+} // namespace ITCH
@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Progress.h"
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace ITCH
+{
+
+namespace
+{
+
+// 0 where /proc isn't available
+std::size_t get_resident_set_size()
+{
+#if defined(__linux__)
+  // Total and resident pages
+  auto        statm = std::ifstream{"/proc/self/statm"};
+  std::size_t nr_pages{};
+  std::size_t nr_resident_pages{};
+
+  if (statm >> nr_pages >> nr_resident_pages)
+  {
+    return nr_resident_pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  }
+#endif
+
+  return 0;
+}
+
+} // namespace
+
+ProgressReporter::ProgressReporter(const ProgressCounters &counters, std::ostream &os,
+                                   std::chrono::milliseconds interval)
+  : m_counters(counters), m_os(os), m_interval(interval), m_start(Clock::now()), m_last_time(m_start),
+    m_thread([this] { run(); })
+{
+}
+
+ProgressReporter::~ProgressReporter()
+{
+  {
+    const auto lock = std::lock_guard{m_mutex};
+    m_stop          = true;
+  }
+
+  m_cv.notify_one();
+  m_thread.join();
+  print();
+}
+
+void ProgressReporter::run()
+{
+  auto lock = std::unique_lock{m_mutex};
+
+  while (!m_cv.wait_for(lock, m_interval, [this] { return m_stop; }))
+  {
+    print();
+  }
+}
+
+void ProgressReporter::print()
+{
+  const auto now         = Clock::now();
+  const auto nr_bytes    = m_counters.nr_bytes.load(std::memory_order_relaxed);
+  const auto nr_messages = m_counters.nr_messages.load(std::memory_order_relaxed);
+  const auto timestamp   = m_counters.timestamp.load(std::memory_order_relaxed);
+  const auto nr_orders   = m_counters.nr_orders.load(std::memory_order_relaxed);
+  const auto elapsed     = std::chrono::duration<double>(now - m_last_time).count();
+  const auto rate        = [elapsed](std::size_t count) { return (elapsed > 0) ? count / elapsed : 0.0; };
+
+  // Progress | wall s | market time | MB/s | messages/s | orders | RSS MB, formatted aside so the format flags of the
+  // shared stream stay as they are
+  std::ostringstream line;
+
+  line << "Progress | " << std::fixed << std::setprecision(1) << std::chrono::duration<double>(now - m_start).count()
+       << " s | " << std::setfill('0') << std::setw(2) << timestamp / HOUR_IN_NANOS << ":" << std::setw(2)
+       << (timestamp / MIN_IN_NANOS) % 60 << ":" << std::setw(2) << (timestamp / SEC_IN_NANOS) % 60
+       << std::setfill(' ') << " | " << rate(nr_bytes - m_last_nr_bytes) / (1024 * 1024) << " MB/s | "
+       << std::setprecision(0) << rate(nr_messages - m_last_nr_messages) << " msgs/s | " << nr_orders << " orders | "
+       << get_resident_set_size() / (1024 * 1024) << " MB RSS\n";
+
+  m_os << line.str() << std::flush;
+
+  m_last_time        = now;
+  m_last_nr_bytes    = nr_bytes;
+  m_last_nr_messages = nr_messages;
+}
+
+} // namespace ITCH
@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Message.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+
+namespace ITCH
+{
+
+// Totals published by the readers and handlers in batches, so the counting stays off the per message path.
+// Counts are added with fetch_add as the decoders of --decoders and the shards of --shards publish concurrently.
+struct ProgressCounters
+{
+  static constexpr std::size_t BYTES_INTERVAL    = 1024 * 1024;
+  static constexpr std::size_t MESSAGES_INTERVAL = 4096;
+
+  std::atomic<std::size_t> nr_bytes{};    // Read, including skipped messages
+  std::atomic<std::size_t> nr_messages{}; // Processed
+  std::atomic<std::size_t> nr_orders{};   // Live, a sum of differences that wraps back for a shrinking book
+  std::atomic<Timestamp_t> timestamp{};   // Market time of the latest published message
+};
+
+// Prints a line with the throughput since the previous line, the order book size, the resident set size and the
+// market time against the wall clock every interval, on a sidecar thread, and a last one when destroyed
+class ProgressReporter
+{
+public:
+  ProgressReporter(const ProgressCounters &counters, std::ostream &os, std::chrono::milliseconds interval);
+  ~ProgressReporter();
+
+  ProgressReporter(const ProgressReporter &)            = delete;
+  ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  void run();
+  void print();
+
+  const ProgressCounters         &m_counters;
+  std::ostream                   &m_os;
+  const std::chrono::milliseconds m_interval;
+  const Clock::time_point         m_start;
+  Clock::time_point               m_last_time;
+  std::size_t                     m_last_nr_bytes{};
+  std::size_t                     m_last_nr_messages{};
+  std::mutex                      m_mutex;
+  std::condition_variable         m_cv;
+  bool                            m_stop{};
+  std::thread                     m_thread;
+};
+
+} // namespace ITCH
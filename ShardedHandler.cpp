@@ -0,0 +1,295 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ShardedHandler.h"
+#include "Stats.h"
+#include <stdexcept>
+
+namespace ITCH
+{
+
+ShardedMessageHandler::ShardedMessageHandler(std::size_t nr_shards, const ReportOptions &report_options)
+  : m_stocks(report_options.periods.size(), report_options.per_period), m_report_schedule(report_options.periods), m_report_writer(report_options)
+{
+  for (std::size_t i = 0; i < nr_shards; ++i)
+  {
+    m_shards.push_back(std::make_unique<Shard>(INITIAL_NR_ORDERS / nr_shards, report_options));
+  }
+
+  for (auto &shard : m_shards)
+  {
+    shard->thread = std::thread([this, &shard = *shard] { run(shard); });
+  }
+}
+
+ShardedMessageHandler::~ShardedMessageHandler()
+{
+  // Not finished, e.g. unwinding, shards exit without processing the rest
+  m_stop = true;
+  join();
+}
+
+void ShardedMessageHandler::handle_message(const Message &message)
+{
+  handle(decode(message));
+}
+
+void ShardedMessageHandler::handle_block(const MessageBlock &block)
+{
+  for (std::size_t i = 0; i < block.size; ++i)
+  {
+    handle(block.decode(i));
+  }
+}
+
+void ShardedMessageHandler::handle(const DecodedMessage &message)
+{
+  if (m_report_schedule.is_due(message.timestamp))
+  {
+    report(message.timestamp);
+  }
+
+  switch (message.type)
+  {
+  case MessageType::SystemEvent:
+    log_system_event(message.timestamp, message.event);
+    return;
+  case MessageType::OrderExecuted:
+  case MessageType::OrderExecutedWithPrice:
+  case MessageType::Trade:
+    m_may_have_executions = true;
+    break;
+  default:
+    break;
+  }
+
+  auto &shard = *m_shards[message.locate % m_shards.size()];
+
+  if (!shard.batch)
+  {
+    next_batch(shard);
+  }
+
+  shard.batch->messages[shard.batch->size++] = message;
+
+  if (DecodedBatch::CAPACITY == shard.batch->size)
+  {
+    publish(shard, false);
+  }
+}
+
+void ShardedMessageHandler::finish()
+{
+  for (auto &shard : m_shards)
+  {
+    if (!shard->batch)
+    {
+      next_batch(*shard);
+    }
+
+    publish(*shard, true);
+  }
+
+  join();
+  rethrow_error();
+
+  if (m_shards.front()->handler.get_stats())
+  {
+    m_stats = std::make_unique<HandlerStats>();
+
+    for (const auto &shard : m_shards)
+    {
+      m_stats->merge(*shard->handler.get_stats());
+    }
+  }
+}
+
+void ShardedMessageHandler::enable_stats()
+{
+  for (auto &shard : m_shards)
+  {
+    shard->handler.enable_stats();
+  }
+}
+
+void ShardedMessageHandler::set_progress(ProgressCounters *progress)
+{
+  for (auto &shard : m_shards)
+  {
+    shard->handler.set_progress(progress);
+  }
+}
+
+void ShardedMessageHandler::flush_progress()
+{
+  for (auto &shard : m_shards)
+  {
+    shard->handler.flush_progress();
+  }
+}
+
+void ShardedMessageHandler::run(Shard &shard)
+{
+  try
+  {
+    for (bool last = false; !last;)
+    {
+      const auto *batch = shard.queue.wait_consume(m_stop);
+
+      if (!batch)
+      {
+        return;
+      }
+
+      for (std::size_t i = 0; i < batch->size; ++i)
+      {
+        shard.handler.process(batch->messages[i]);
+      }
+
+      last = batch->last;
+      shard.queue.consume();
+    }
+  }
+  catch (...)
+  {
+    shard.error = std::current_exception();
+    m_stop      = true;
+  }
+}
+
+void ShardedMessageHandler::next_batch(Shard &shard)
+{
+  shard.batch = shard.queue.wait_produce(m_stop);
+
+  if (!shard.batch)
+  {
+    fail();
+  }
+
+  shard.batch->size = 0;
+}
+
+void ShardedMessageHandler::publish(Shard &shard, bool last)
+{
+  shard.batch->last = last;
+  shard.batch       = nullptr;
+  shard.queue.produce();
+}
+
+void ShardedMessageHandler::report(Timestamp_t current_time)
+{
+  // Only shards know whether an execution matched an order, they are asked from the first possible execution on
+  if (m_may_have_executions)
+  {
+    merge_stocks();
+  }
+
+  // The schedule moves on from the first message, so the first execution is reported with the period it is in
+  m_report_schedule.advance(current_time, [&](std::size_t index, Timestamp_t period, Timestamp_t report_time) {
+    if (m_stocks.has_executions)
+    {
+      m_report_writer.write(m_stocks, index, period, report_time, current_time);
+
+      for (auto &shard : m_shards)
+      {
+        shard->handler.clear_period(index);
+      }
+    }
+  });
+}
+
+void ShardedMessageHandler::merge_stocks()
+{
+  for (auto &shard : m_shards)
+  {
+    if (shard->batch && shard->batch->size)
+    {
+      publish(*shard, false);
+    }
+  }
+
+  for (auto &shard : m_shards)
+  {
+    while (!shard->queue.empty())
+    {
+      if (m_stop)
+      {
+        fail();
+      }
+
+      std::this_thread::yield();
+    }
+  }
+
+  // Shards are idle until more messages are routed, each locate is owned by exactly one of them
+  m_stocks.clear();
+
+  for (const auto &shard : m_shards)
+  {
+    const auto &stocks = shard->handler.get_stocks();
+
+    for (std::size_t bar_set = 0; bar_set < stocks.nr_bar_sets; ++bar_set)
+    {
+      for (const auto locate : stocks.traded[bar_set])
+      {
+        m_stocks.set_bar(locate, bar_set, stocks.get_bar(locate, bar_set));
+        m_stocks.symbols[locate] = stocks.symbols[locate];
+      }
+    }
+
+    m_stocks.has_executions = m_stocks.has_executions || stocks.has_executions;
+  }
+
+  m_may_have_executions = m_stocks.has_executions;
+}
+
+void ShardedMessageHandler::join()
+{
+  for (auto &shard : m_shards)
+  {
+    if (shard->thread.joinable())
+    {
+      shard->thread.join();
+    }
+  }
+}
+
+void ShardedMessageHandler::rethrow_error()
+{
+  for (auto &shard : m_shards)
+  {
+    if (shard->error)
+    {
+      std::rethrow_exception(shard->error);
+    }
+  }
+}
+
+void ShardedMessageHandler::fail()
+{
+  m_stop = true;
+  join();
+  rethrow_error();
+  throw std::runtime_error("Shard stopped unexpectedly");
+}
+
+} // namespace ITCH
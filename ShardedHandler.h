@@ -0,0 +1,99 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Message.h"
+#include "Pipeline.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace ITCH
+{
+
+// Order state is partitioned by stock locate, so messages are routed by locate to N shards, each processing them
+// on its own thread with its own orders and stock table. At a report the dispatcher waits for the shards to drain
+// their queues and merges their stock tables, the reports are identical to a single MessageHandler's.
+class ShardedMessageHandler
+{
+public:
+  explicit ShardedMessageHandler(std::size_t nr_shards, const ReportOptions &report_options = {});
+  ~ShardedMessageHandler();
+
+  void handle_message(const Message &message);
+  void handle(const DecodedMessage &message);
+  void handle_block(const MessageBlock &block);
+  // Processes all routed messages and stops the shards, rethrows a failure of a shard
+  void finish();
+
+  // Enables the stats of every shard, merged by finish()
+  void enable_stats();
+  // The shards add to the same counters
+  void set_progress(ProgressCounters *progress);
+  // Adds the last counts of the shards, once finished
+  void flush_progress();
+
+  const HandlerStats *get_stats() const
+  {
+    return m_stats.get();
+  }
+
+private:
+  struct Shard
+  {
+    Shard(std::size_t initial_nr_orders, const ReportOptions &report_options)
+      : handler(initial_nr_orders, report_options), queue(PIPELINE_QUEUE_SIZE)
+    {
+    }
+
+    MessageHandler          handler;
+    SpscQueue<DecodedBatch> queue;
+    DecodedBatch           *batch{}; // Being filled by the dispatcher
+    std::exception_ptr      error;
+    std::thread             thread;
+  };
+
+  void run(Shard &shard);
+  void next_batch(Shard &shard);
+  void publish(Shard &shard, bool last);
+  void report(Timestamp_t current_time);
+  // Waits for the shards to drain their queues and merges their stock tables
+  void merge_stocks();
+  void join();
+  void rethrow_error();
+  // A shard failed, stops the others and rethrows its exception
+  [[noreturn]] void fail();
+
+  std::vector<std::unique_ptr<Shard>> m_shards;
+  std::atomic<bool>                   m_stop{};
+  StockTable                          m_stocks; // Merged for reports
+  ReportSchedule                      m_report_schedule;
+  ReportWriter                        m_report_writer;
+  bool                                m_may_have_executions{};
+  std::unique_ptr<HandlerStats>       m_stats;
+};
+
+} // namespace ITCH
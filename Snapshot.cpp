@@ -0,0 +1,248 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Snapshot.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ITCH
+{
+
+// Host byte order, snapshots are caches next to the file rather than an exchange format
+constexpr char SNAPSHOT_MAGIC[8]   = {'I', 'T', 'C', 'H', 'S', 'N', 'P', '6'};
+constexpr char TIME_INDEX_MAGIC[8] = {'I', 'T', 'C', 'H', 'T', 'I', 'X', '1'};
+
+struct SnapshotHeader
+{
+  char             magic[sizeof(SNAPSHOT_MAGIC)];
+  SnapshotPosition position;
+};
+
+struct TimeIndexHeader
+{
+  char          magic[sizeof(TIME_INDEX_MAGIC)];
+  std::uint64_t file_size;
+  std::uint64_t nr_positions;
+};
+
+void save_snapshot(const std::string &path, const MessageHandler &handler, const SnapshotPosition &position)
+{
+  SnapshotHeader header{};
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.position = position;
+
+  // Written aside and renamed, a crash never leaves a truncated snapshot behind
+  const auto    temporary_path = path + ".tmp";
+  std::ofstream ofs(temporary_path, std::ios::binary | std::ios::trunc);
+
+  ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  handler.save(ofs);
+  ofs.close();
+
+  if (!ofs || std::rename(temporary_path.c_str(), path.c_str()))
+  {
+    throw "Failed to write snapshot!";
+  }
+}
+
+SnapshotPosition load_snapshot(const std::string &path, MessageHandler &handler)
+{
+  std::ifstream  ifs(path, std::ios::binary);
+  SnapshotHeader header{};
+
+  if (!ifs.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      (0 != std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC))))
+  {
+    throw "Invalid snapshot!";
+  }
+
+  handler.load(ifs);
+  return header.position;
+}
+
+std::string TimeIndex::get_path(const std::string &filename)
+{
+  return filename + ".tidx";
+}
+
+std::string TimeIndex::get_snapshot_path(const std::string &filename, Timestamp_t timestamp)
+{
+  std::stringstream path;
+
+  path << filename << "." << std::setfill('0') << std::setw(2) << timestamp / HOUR_IN_NANOS << std::setw(2)
+       << (timestamp / MIN_IN_NANOS) % 60 << std::setw(2) << (timestamp / SEC_IN_NANOS) % 60 << ".snap";
+  return path.str();
+}
+
+bool TimeIndex::load(const std::string &filename)
+{
+  std::ifstream   ifs(get_path(filename), std::ios::binary);
+  TimeIndexHeader header{};
+
+  if (!ifs.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      (0 != std::memcmp(header.magic, TIME_INDEX_MAGIC, sizeof(TIME_INDEX_MAGIC))) ||
+      (header.file_size != m_file_size) || (header.nr_positions > m_file_size))
+  {
+    return false;
+  }
+
+  m_positions.resize(header.nr_positions);
+  return static_cast<bool>(
+    ifs.read(reinterpret_cast<char *>(m_positions.data()), m_positions.size() * sizeof(SnapshotPosition)));
+}
+
+void TimeIndex::save(const std::string &filename) const
+{
+  TimeIndexHeader header{};
+  std::memcpy(header.magic, TIME_INDEX_MAGIC, sizeof(TIME_INDEX_MAGIC));
+  header.file_size    = m_file_size;
+  header.nr_positions = m_positions.size();
+
+  std::ofstream ofs(get_path(filename), std::ios::binary | std::ios::trunc);
+  ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  ofs.write(reinterpret_cast<const char *>(m_positions.data()), m_positions.size() * sizeof(SnapshotPosition));
+
+  if (!ofs)
+  {
+    std::cerr << "Failed to write " << get_path(filename) << std::endl;
+  }
+}
+
+const SnapshotPosition *TimeIndex::find(Timestamp_t timestamp) const
+{
+  // Positions are added in file order
+  const auto iter = std::upper_bound(m_positions.begin(), m_positions.end(), timestamp,
+                                     [](Timestamp_t lhs, const SnapshotPosition &rhs) { return lhs < rhs.timestamp; });
+
+  return (m_positions.begin() == iter) ? nullptr : &*std::prev(iter);
+}
+
+std::string Checkpointer::get_path(const std::string &filename)
+{
+  return filename + ".ckpt";
+}
+
+Checkpointer::Checkpointer(const std::string &filename, Timestamp_t interval)
+  : m_path(get_path(filename)), m_interval(interval)
+{
+}
+
+Checkpointer::~Checkpointer()
+{
+  wait_child(true);
+}
+
+std::optional<SnapshotPosition> Checkpointer::restore(MessageHandler &handler)
+{
+  if (std::ifstream(m_path).fail())
+  {
+    return std::nullopt;
+  }
+
+  const auto position = load_snapshot(m_path, handler);
+  m_next_time         = position.timestamp + m_interval;
+  return position;
+}
+
+void Checkpointer::checkpoint(const Message &message, MessageHandler &handler)
+{
+  const auto timestamp     = message.get_timestamp();
+  const auto snapshot_time = (timestamp / m_interval) * m_interval;
+  const auto first         = (0 == m_next_time);
+
+  m_next_time = snapshot_time + m_interval;
+
+  // Nothing to checkpoint before the first message, and a slow disk skips a checkpoint rather than the hot loop
+  // waiting for it
+  if (first || !wait_child(false))
+  {
+    return;
+  }
+
+  // The checkpoint holds the reports so far as written, a run killed after it would never write the queued ones
+  handler.flush_reports();
+
+  const auto position = SnapshotPosition{message.get_offset(), snapshot_time};
+  const auto pid      = fork();
+
+  if (0 == pid)
+  {
+    try
+    {
+      save_snapshot(m_path, handler, position);
+    }
+    catch (...)
+    {
+      _exit(EXIT_FAILURE);
+    }
+
+    _exit(EXIT_SUCCESS);
+  }
+
+  if (pid < 0)
+  {
+    std::cerr << "Failed to fork for a checkpoint" << std::endl;
+    return;
+  }
+
+  m_child = pid;
+}
+
+bool Checkpointer::wait_child(bool block)
+{
+  if (m_child < 0)
+  {
+    return true;
+  }
+
+  int        status{};
+  const auto pid = waitpid(m_child, &status, block ? 0 : WNOHANG);
+
+  if (0 == pid)
+  {
+    return false;
+  }
+
+  if ((pid < 0) || !WIFEXITED(status) || (EXIT_SUCCESS != WEXITSTATUS(status)))
+  {
+    std::cerr << "Failed to write " << m_path << std::endl;
+  }
+
+  m_child = -1;
+  return true;
+}
+
+void Checkpointer::finish()
+{
+  wait_child(true);
+  std::remove(m_path.c_str());
+}
+
+} // namespace ITCH
@@ -0,0 +1,113 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Message.h"
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace ITCH
+{
+
+// Where the replay resumes after loading a snapshot: the offset of the first message not contained in it and the
+// time all messages before it precede
+struct SnapshotPosition
+{
+  std::uint64_t offset{};
+  Timestamp_t   timestamp{};
+};
+
+void save_snapshot(const std::string &path, const MessageHandler &handler, const SnapshotPosition &position);
+SnapshotPosition load_snapshot(const std::string &path, MessageHandler &handler);
+
+// Snapshots of the handler state at regular times of day of a memory mapped file, so a run can start at any time
+// without replaying the file before it. "<file>.tidx" lists them, "<file>.<HHMMSS>.snap" holds each.
+class TimeIndex
+{
+public:
+  static std::string get_path(const std::string &filename);
+  static std::string get_snapshot_path(const std::string &filename, Timestamp_t timestamp);
+
+  explicit TimeIndex(std::size_t file_size) : m_file_size(file_size)
+  {
+  }
+
+  bool load(const std::string &filename);
+  void save(const std::string &filename) const;
+
+  void add(const SnapshotPosition &position)
+  {
+    m_positions.push_back(position);
+  }
+
+  // Latest snapshot at or before timestamp, nullptr if there is none
+  const SnapshotPosition *find(Timestamp_t timestamp) const;
+
+private:
+  std::vector<SnapshotPosition> m_positions;
+  std::size_t                   m_file_size{};
+};
+
+// Periodic checkpoints of the handler state to "<file>.ckpt", so a run that died can resume from the newest one.
+// A forked child writes each checkpoint from its copy-on-write image of the process, the hot loop only pays for the
+// fork.
+class Checkpointer
+{
+public:
+  static std::string get_path(const std::string &filename);
+
+  Checkpointer(const std::string &filename, Timestamp_t interval);
+  ~Checkpointer();
+
+  Checkpointer(const Checkpointer &)            = delete;
+  Checkpointer &operator=(const Checkpointer &) = delete;
+
+  // Loads the newest checkpoint into handler, the position to resume from if there is one
+  std::optional<SnapshotPosition> restore(MessageHandler &handler);
+
+  // Checkpoints the handler state before message when an interval of market time has passed
+  void on_message(const Message &message, MessageHandler &handler)
+  {
+    if (message.get_timestamp() >= m_next_time)
+    {
+      checkpoint(message, handler);
+    }
+  }
+
+  // Removes the checkpoint once the run completed
+  void finish();
+
+private:
+  void checkpoint(const Message &message, MessageHandler &handler);
+  // Reaps the child writing the last checkpoint, false if it is still running
+  bool wait_child(bool block);
+
+  const std::string m_path;
+  const Timestamp_t m_interval;
+  Timestamp_t       m_next_time{};
+  pid_t             m_child{-1};
+};
+
+} // namespace ITCH
@@ -0,0 +1,138 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ITCH
+{
+
+// Lock-free ring of preallocated slots for exactly one producer and one consumer thread. The producer fills the slot
+// returned by try_produce() in place and publishes it with produce(), the consumer reads the slot returned by
+// try_consume() and hands it back with consume().
+template <typename T> class SpscQueue
+{
+public:
+  explicit SpscQueue(std::size_t capacity) : m_slots(std::bit_ceil(capacity)), m_mask(m_slots.size() - 1)
+  {
+  }
+
+  SpscQueue(const SpscQueue &)            = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  T *try_produce()
+  {
+    const auto head = m_head.load(std::memory_order_relaxed);
+
+    if (head - m_cached_tail == m_slots.size())
+    {
+      m_cached_tail = m_tail.load(std::memory_order_acquire);
+
+      if (head - m_cached_tail == m_slots.size())
+      {
+        return nullptr;
+      }
+    }
+
+    return &m_slots[head & m_mask];
+  }
+
+  void produce()
+  {
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  T *try_consume()
+  {
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+
+    if (tail == m_cached_head)
+    {
+      m_cached_head = m_head.load(std::memory_order_acquire);
+
+      if (tail == m_cached_head)
+      {
+        return nullptr;
+      }
+    }
+
+    return &m_slots[tail & m_mask];
+  }
+
+  void consume()
+  {
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // True once the consumer handed back every produced slot, for the producer to wait until all were processed
+  bool empty() const
+  {
+    return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_relaxed);
+  }
+
+  // Blocking variants, yielding while the queue is full (empty) unless `stop` is set, nullptr then
+  T *wait_produce(const std::atomic<bool> &stop)
+  {
+    return wait([this] { return try_produce(); }, stop);
+  }
+
+  T *wait_consume(const std::atomic<bool> &stop)
+  {
+    return wait([this] { return try_consume(); }, stop);
+  }
+
+private:
+  template <typename F> static T *wait(F &&try_get, const std::atomic<bool> &stop)
+  {
+    for (;;)
+    {
+      if (auto *slot = try_get())
+      {
+        return slot;
+      }
+
+      if (stop.load(std::memory_order_relaxed))
+      {
+        return nullptr;
+      }
+
+      std::this_thread::yield();
+    }
+  }
+
+  static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+  // Each index shares its cache line only with the cached copy of the other index read by the same thread
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_head{};
+  std::size_t m_cached_tail{};
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail{};
+  std::size_t m_cached_head{};
+  alignas(CACHE_LINE_SIZE) std::vector<T> m_slots;
+  const std::size_t m_mask;
+};
+
+} // namespace ITCH
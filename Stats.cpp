@@ -0,0 +1,155 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Stats.h"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+namespace ITCH
+{
+
+void TickHistogram::merge(const TickHistogram &other)
+{
+  for (std::size_t bucket = 0; bucket < NR_BUCKETS; ++bucket)
+  {
+    m_buckets[bucket] += other.m_buckets[bucket];
+  }
+
+  m_count += other.m_count;
+  m_total += other.m_total;
+  m_max    = std::max(m_max, other.m_max);
+}
+
+std::uint64_t TickHistogram::get_upper_bound(std::size_t bucket)
+{
+  if (bucket < NR_LINEAR)
+  {
+    return bucket;
+  }
+
+  const auto exponent = (bucket - NR_LINEAR) / NR_SUBBUCKETS + SUB_BITS + 1;
+  const auto lower    = (NR_SUBBUCKETS + (bucket - NR_LINEAR) % NR_SUBBUCKETS) << (exponent - SUB_BITS);
+  return lower + (std::uint64_t{1} << (exponent - SUB_BITS)) - 1;
+}
+
+std::uint64_t TickHistogram::get_percentile(double percentile) const
+{
+  const auto    rank = static_cast<std::uint64_t>(percentile / 100 * static_cast<double>(m_count));
+  std::uint64_t seen{};
+
+  for (std::size_t bucket = 0; bucket < NR_BUCKETS; ++bucket)
+  {
+    seen += m_buckets[bucket];
+
+    if (seen > rank)
+    {
+      return std::min(get_upper_bound(bucket), m_max);
+    }
+  }
+
+  return m_max;
+}
+
+void HandlerStats::sample(Timestamp_t timestamp, std::size_t nr_orders, std::size_t capacity)
+{
+  const auto time    = timestamp / SAMPLE_INTERVAL * SAMPLE_INTERVAL;
+  m_next_sample_time = time + SAMPLE_INTERVAL;
+  m_samples.push_back({time, nr_orders, capacity});
+}
+
+void HandlerStats::merge(const HandlerStats &other)
+{
+  for (std::size_t type = 0; type < m_histograms.size(); ++type)
+  {
+    m_histograms[type].merge(other.m_histograms[type]);
+  }
+
+  for (const auto &sample : other.m_samples)
+  {
+    const auto iter = std::find_if(m_samples.begin(), m_samples.end(),
+                                   [&](const Sample &other_sample) { return other_sample.time == sample.time; });
+
+    if (m_samples.end() == iter)
+    {
+      m_samples.push_back(sample);
+    }
+    else
+    {
+      iter->nr_orders += sample.nr_orders;
+      iter->capacity += sample.capacity;
+    }
+  }
+
+  std::sort(m_samples.begin(), m_samples.end(), [](const Sample &a, const Sample &b) { return a.time < b.time; });
+}
+
+void HandlerStats::print(std::ostream &os) const
+{
+#if defined(COMPILER_SUPPORTS_RDTSC)
+  constexpr auto unit = "TSC ticks";
+#else
+  constexpr auto unit = "ns";
+#endif
+
+  auto total = TickHistogram{};
+
+  os << "Stats | Type | Messages | Mean | p50 | p90 | p99 | p99.9 | Max (" << unit << ")" << std::endl;
+
+  const auto print_histogram = [&](const char *name, const TickHistogram &histogram) {
+    os << "Stats | " << name << " | " << histogram.get_count() << " | "
+       << histogram.get_total() / std::max<std::uint64_t>(histogram.get_count(), 1);
+
+    for (const auto percentile : {50.0, 90.0, 99.0, 99.9})
+    {
+      os << " | " << histogram.get_percentile(percentile);
+    }
+
+    os << " | " << histogram.get_max() << std::endl;
+  };
+
+  for (std::size_t type = 0; type < m_histograms.size(); ++type)
+  {
+    if (m_histograms[type].get_count())
+    {
+      const char name[] = {static_cast<char>(type), '\0'};
+      print_histogram(name, m_histograms[type]);
+      total.merge(m_histograms[type]);
+    }
+  }
+
+  print_histogram("All", total);
+
+  os << "Stats | Time | Orders | Capacity | Load factor" << std::endl;
+
+  for (const auto &sample : m_samples)
+  {
+    os << "Stats | " << std::setfill('0') << std::setw(2) << sample.time / HOUR_IN_NANOS << ":" << std::setw(2)
+       << sample.time / MIN_IN_NANOS % 60 << std::setfill(' ') << " | " << sample.nr_orders << " | "
+       << sample.capacity << " | " << std::fixed << std::setprecision(3)
+       << static_cast<double>(sample.nr_orders) / static_cast<double>(std::max<std::size_t>(sample.capacity, 1))
+       << std::defaultfloat << std::endl;
+  }
+}
+
+} // namespace ITCH
@@ -0,0 +1,153 @@
+// MIT License
+//
+// Copyright (c) 2024 Ufuk Dalli
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Message.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#if defined(COMPILER_SUPPORTS_RDTSC)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace ITCH
+{
+
+// Time stamp counter ticks where available, steady clock nanoseconds otherwise
+inline std::uint64_t read_ticks()
+{
+#if defined(COMPILER_SUPPORTS_RDTSC)
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Log-linear histogram as in HdrHistogram: exact below 16, then 8 buckets per power of two, within 12.5%
+class TickHistogram
+{
+public:
+  void record(std::uint64_t ticks)
+  {
+    ++m_buckets[get_bucket(ticks)];
+    ++m_count;
+    m_total += ticks;
+    m_max    = std::max(m_max, ticks);
+  }
+
+  void merge(const TickHistogram &other);
+
+  std::uint64_t get_count() const
+  {
+    return m_count;
+  }
+
+  std::uint64_t get_total() const
+  {
+    return m_total;
+  }
+
+  std::uint64_t get_max() const
+  {
+    return m_max;
+  }
+
+  // Upper bound of the bucket holding the given percentile
+  std::uint64_t get_percentile(double percentile) const;
+
+private:
+  static constexpr unsigned    SUB_BITS      = 3;
+  static constexpr std::size_t NR_SUBBUCKETS = std::size_t{1} << SUB_BITS;
+  static constexpr std::size_t NR_LINEAR     = 2 * NR_SUBBUCKETS;
+  static constexpr std::size_t NR_BUCKETS    = NR_LINEAR + (64 - SUB_BITS - 1) * NR_SUBBUCKETS;
+
+  static std::size_t get_bucket(std::uint64_t ticks)
+  {
+    if (ticks < NR_LINEAR)
+    {
+      return static_cast<std::size_t>(ticks);
+    }
+
+    const auto exponent = static_cast<unsigned>(std::bit_width(ticks)) - 1;
+    return NR_LINEAR + (exponent - SUB_BITS - 1) * NR_SUBBUCKETS +
+           static_cast<std::size_t>((ticks >> (exponent - SUB_BITS)) & (NR_SUBBUCKETS - 1));
+  }
+
+  static std::uint64_t get_upper_bound(std::size_t bucket);
+
+  std::array<std::uint64_t, NR_BUCKETS> m_buckets{};
+  std::uint64_t                         m_count{};
+  std::uint64_t                         m_total{};
+  std::uint64_t                         m_max{};
+};
+
+// Message counts and processing time histograms by message type, i.e. by branch of MessageHandler::process(), and
+// the size of the order book over time. Only allocated with --stats.
+class HandlerStats
+{
+public:
+  static constexpr Timestamp_t SAMPLE_INTERVAL = 30 * MIN_IN_NANOS;
+
+  void record(MessageType type, std::uint64_t ticks)
+  {
+    m_histograms[static_cast<unsigned char>(type)].record(ticks);
+  }
+
+  bool is_sample_due(Timestamp_t timestamp) const
+  {
+    return timestamp >= m_next_sample_time;
+  }
+
+  // The order book at the first message of a sample interval
+  void sample(Timestamp_t timestamp, std::size_t nr_orders, std::size_t capacity);
+
+  // Adds the stats of a shard, the order book samples of the same interval are summed up
+  void merge(const HandlerStats &other);
+
+  // Summary lines starting with "Stats |"
+  void print(std::ostream &os) const;
+
+private:
+  struct Sample
+  {
+    Timestamp_t time{};
+    std::size_t nr_orders{};
+    std::size_t capacity{}; // Slots allocated by the order map
+  };
+
+  std::array<TickHistogram, 256> m_histograms;
+  std::vector<Sample>            m_samples;
+  Timestamp_t                    m_next_sample_time{};
+};
+
+} // namespace ITCH
@@ -17,3 +17,9 @@ mkdir build && cd build && cmake .. && make all
 /usr/bin/time -v ./ITCH50_Hourly_VWAP ${ITCH50_FILE_PATH} &> "${ITCH50_FILE_PATH}.time"
 perf record -o "${ITCH50_FILE_PATH}.perf.data" -e cache-references,cache-misses,cycles,instructions,branches,faults,migrations ./ITCH50_Hourly_VWAP "${ITCH50_FILE_PATH}"
 valgrind --tool=callgrind --collect-systime=msec --callgrind-out-file="${ITCH50_FILE_PATH}.callgrind.out" ./ITCH50_Hourly_VWAP "${ITCH50_FILE_PATH}"
+
+# Microbenchmarks on synthetic messages, only built when Google Benchmark is installed
+if [ -x ./ITCH50_Benchmark ]
+then
+  ./ITCH50_Benchmark --benchmark_out="${ITCH50_FILE_PATH}.benchmark.json" --benchmark_out_format=json
+fi
@@ -21,30 +21,657 @@
 // SOFTWARE.
 
 #include "Message.h"
+#include "MessageIndex.h"
+#include "PerfCounters.h"
+#include "Pipeline.h"
+#include "Progress.h"
+#include "ShardedHandler.h"
+#include "Snapshot.h"
+#include "Stats.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Options
+{
+  std::string filename;
+  bool        pipeline{};
+  std::size_t nr_decoders{1};
+  std::size_t nr_shards{};
+  bool        build_index{};
+  bool        stats{};
+  bool        perf{};
+
+  std::chrono::seconds progress_interval{};
+
+  ITCH::Timestamp_t start{};
+  ITCH::Timestamp_t end{std::numeric_limits<ITCH::Timestamp_t>::max()};
+  ITCH::Timestamp_t time_index_interval{};
+  ITCH::Timestamp_t checkpoint_interval{};
+
+  ITCH::ReportOptions report;
+};
+
+void print_usage()
+{
+  std::cout << "Usage:" << std::endl
+            << "\tITCH50_Hourly_VWAP [options] <NASDAQ ITCH 5.0 file, unzipped or *.gz>" << std::endl
+            << "\tExample: ITCH50_Hourly_VWAP 01302019.NASDAQ_ITCH50" << std::endl
+            << "\tExample: ITCH50_Hourly_VWAP 01302019.NASDAQ_ITCH50.gz" << std::endl
+            << "Options:" << std::endl
+            << "\t--pipeline\tRead and decode messages on a separate thread" << std::endl
+            << "\t--decoders <N>\tDecode chunks of an unzipped file on N threads, implies --pipeline" << std::endl
+            << "\t--shards <N>\tProcess messages on N threads, partitioned by stock locate" << std::endl
+            << "\t--intervals <list>" << std::endl
+            << "\t\t\tReport periods, e.g. 1m,5m,1h, 1h by default" << std::endl
+            << "\t--per-period\tReport the executions within each period rather than since the start of the day"
+            << std::endl
+            << "\t--symbols <list>" << std::endl
+            << "\t\t\tTrack and report the given stocks only, e.g. AAPL,MSFT" << std::endl
+            << "\t--stats\t\tPrint message counts and processing times by type and the order book size over time"
+            << std::endl
+            << "\t--perf\t\tPrint hardware counters and page faults of the handling thread by phase and hour of market"
+            << std::endl
+            << "\t\t\ttime, where perf_event_open is available" << std::endl
+            << "\t--progress <seconds>" << std::endl
+            << "\t\t\tPrint MB/s, messages/s, live orders, RSS and market time to stderr every <seconds>"
+            << std::endl
+            << "\t--precision <N>\tNumber of VWAP decimals, 4 by default" << std::endl
+            << "\t--build-index\tWrite the message boundary index of an unzipped file (<file>.idx) and exit"
+            << std::endl
+            << "\t--build-time-index <minutes>" << std::endl
+            << "\t\t\tSnapshot the order book of an unzipped file every <minutes> of market time" << std::endl
+            << "\t--start <HH:MM[:SS]>, --end <HH:MM[:SS]>" << std::endl
+            << "\t\t\tReport the VWAP of the executions within the time window only, starting from the latest"
+            << std::endl
+            << "\t\t\tsnapshot before it when there is a time index" << std::endl
+            << "\t--checkpoint <minutes>" << std::endl
+            << "\t\t\tCheckpoint every <minutes> of market time to <file>.ckpt, resume from it on restart"
+            << std::endl;
+}
+
+bool is_time_window(const Options &options)
+{
+  return options.start || (Options{}.end != options.end);
+}
+
+bool parse_number(std::string_view arg, std::size_t &value)
+{
+  const auto [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+  return (std::errc{} == error) && (arg.data() + arg.size() == end);
+}
+
+bool parse_time(std::string_view arg, ITCH::Timestamp_t &value)
+{
+  // HH:MM[:SS]
+  std::size_t hour{};
+  std::size_t min{};
+  std::size_t sec{};
+
+  if ((arg.size() != 5) && (arg.size() != 8))
+  {
+    return false;
+  }
+
+  if (!parse_number(arg.substr(0, 2), hour) || (':' != arg[2]) || !parse_number(arg.substr(3, 2), min) ||
+      ((arg.size() == 8) && ((':' != arg[5]) || !parse_number(arg.substr(6, 2), sec))))
+  {
+    return false;
+  }
+
+  value = hour * ITCH::HOUR_IN_NANOS + min * ITCH::MIN_IN_NANOS + sec * ITCH::SEC_IN_NANOS;
+  return true;
+}
+
+bool parse_periods(std::string_view arg, std::vector<ITCH::Timestamp_t> &periods)
+{
+  // Comma separated <N>s, <N>m or <N>h
+  periods.clear();
+
+  while (!arg.empty())
+  {
+    const auto  period = arg.substr(0, arg.find(','));
+    std::size_t count{};
+
+    arg.remove_prefix(std::min(arg.size(), period.size() + 1));
+
+    if ((period.size() < 2) || !parse_number(period.substr(0, period.size() - 1), count) || (0 == count))
+    {
+      return false;
+    }
+
+    switch (period.back())
+    {
+    case 's':
+      periods.push_back(count * ITCH::SEC_IN_NANOS);
+      break;
+    case 'm':
+      periods.push_back(count * ITCH::MIN_IN_NANOS);
+      break;
+    case 'h':
+      periods.push_back(count * ITCH::HOUR_IN_NANOS);
+      break;
+    default:
+      return false;
+    }
+  }
+
+  std::sort(periods.begin(), periods.end());
+  periods.erase(std::unique(periods.begin(), periods.end()), periods.end());
+  return !periods.empty();
+}
+
+bool parse_symbols(std::string_view arg, std::vector<ITCH::Stock_t> &symbols)
+{
+  // Comma separated, space padded like the Stock fields of the messages
+  symbols.clear();
+
+  while (!arg.empty())
+  {
+    const auto symbol = arg.substr(0, arg.find(','));
+    auto       stock  = ITCH::Stock_t{};
+
+    arg.remove_prefix(std::min(arg.size(), symbol.size() + 1));
+
+    if (symbol.empty() || (symbol.size() > stock.size()))
+    {
+      return false;
+    }
+
+    stock.fill(' ');
+    std::copy(symbol.begin(), symbol.end(), stock.begin());
+    symbols.push_back(stock);
+  }
+
+  std::sort(symbols.begin(), symbols.end());
+  return !symbols.empty();
+}
+
+bool parse_options(int argc, char *argv[], Options &options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const auto arg = std::string_view(argv[i]);
+
+    if ("--pipeline" == arg)
+    {
+      options.pipeline = true;
+    }
+    else if ("--stats" == arg)
+    {
+      options.stats = true;
+    }
+    else if ("--perf" == arg)
+    {
+      options.perf = true;
+    }
+    else if ("--per-period" == arg)
+    {
+      options.report.per_period = true;
+    }
+    else if ("--decoders" == arg)
+    {
+      if ((++i == argc) || !parse_number(argv[i], options.nr_decoders) || (0 == options.nr_decoders))
+      {
+        std::cerr << "--decoders expects a positive number" << std::endl;
+        return false;
+      }
+
+      options.pipeline = true;
+    }
+    else if ("--progress" == arg)
+    {
+      std::size_t seconds{};
+
+      if ((++i == argc) || !parse_number(argv[i], seconds) || (0 == seconds))
+      {
+        std::cerr << "--progress expects a positive number of seconds" << std::endl;
+        return false;
+      }
+
+      options.progress_interval = std::chrono::seconds(seconds);
+    }
+    else if ("--build-index" == arg)
+    {
+      options.build_index = true;
+    }
+    else if ("--shards" == arg)
+    {
+      if ((++i == argc) || !parse_number(argv[i], options.nr_shards) || (0 == options.nr_shards))
+      {
+        std::cerr << "--shards expects a positive number" << std::endl;
+        return false;
+      }
+    }
+    else if ("--build-time-index" == arg)
+    {
+      std::size_t minutes{};
+
+      if ((++i == argc) || !parse_number(argv[i], minutes) || (0 == minutes))
+      {
+        std::cerr << "--build-time-index expects a positive number of minutes" << std::endl;
+        return false;
+      }
+
+      options.time_index_interval = minutes * ITCH::MIN_IN_NANOS;
+    }
+    else if ("--precision" == arg)
+    {
+      std::size_t decimals{};
+
+      if ((++i == argc) || !parse_number(argv[i], decimals) || (decimals > ITCH::MAX_VWAP_DECIMALS))
+      {
+        std::cerr << "--precision expects a number of decimals up to " << ITCH::MAX_VWAP_DECIMALS << std::endl;
+        return false;
+      }
+
+      options.report.vwap_decimals = static_cast<unsigned>(decimals);
+    }
+    else if ("--intervals" == arg)
+    {
+      if ((++i == argc) || !parse_periods(argv[i], options.report.periods))
+      {
+        std::cerr << "--intervals expects a comma separated list of <N>s, <N>m or <N>h" << std::endl;
+        return false;
+      }
+    }
+    else if ("--symbols" == arg)
+    {
+      if ((++i == argc) || !parse_symbols(argv[i], options.report.symbols))
+      {
+        std::cerr << "--symbols expects a comma separated list of symbols of up to 8 characters" << std::endl;
+        return false;
+      }
+    }
+    else if ("--checkpoint" == arg)
+    {
+      std::size_t minutes{};
+
+      if ((++i == argc) || !parse_number(argv[i], minutes) || (0 == minutes))
+      {
+        std::cerr << "--checkpoint expects a positive number of minutes" << std::endl;
+        return false;
+      }
+
+      options.checkpoint_interval = minutes * ITCH::MIN_IN_NANOS;
+    }
+    else if (("--start" == arg) || ("--end" == arg))
+    {
+      if ((++i == argc) || !parse_time(argv[i], ("--start" == arg) ? options.start : options.end))
+      {
+        std::cerr << arg << " expects a time of day as HH:MM or HH:MM:SS" << std::endl;
+        return false;
+      }
+    }
+    else if (arg.starts_with("--") || !options.filename.empty())
+    {
+      std::cerr << "Unexpected argument: " << arg << std::endl;
+      return false;
+    }
+    else
+    {
+      options.filename = arg;
+    }
+  }
+
+  const auto time_options =
+      options.time_index_interval || options.checkpoint_interval || is_time_window(options);
+
+  if (time_options && (options.pipeline || options.nr_shards))
+  {
+    std::cerr << "Time index, window and checkpoint options cannot be combined with --pipeline, --decoders or "
+                 "--shards"
+              << std::endl;
+    return false;
+  }
+
+  if (options.perf && options.nr_shards)
+  {
+    std::cerr << "--perf cannot be combined with --shards" << std::endl;
+    return false;
+  }
+
+  if (options.checkpoint_interval && (options.time_index_interval || is_time_window(options)))
+  {
+    std::cerr << "--checkpoint cannot be combined with --build-time-index, --start or --end" << std::endl;
+    return false;
+  }
+
+  if (options.time_index_interval && is_time_window(options))
+  {
+    std::cerr << "--build-time-index cannot be combined with --start or --end" << std::endl;
+    return false;
+  }
+
+  if (options.start >= options.end)
+  {
+    std::cerr << "--start has to be before --end" << std::endl;
+    return false;
+  }
+
+  return !options.filename.empty();
+}
+
+template <typename Handler>
+void run(ITCH::MessageReader &message_reader, Handler &message_handler, const Options &options)
+{
+  if (options.pipeline && (options.nr_decoders > 1) && message_reader.is_mapped())
+  {
+    const auto index = ITCH::MessageIndex::load_or_build(options.filename, message_reader);
+    ITCH::run_pipelined(message_reader, message_handler, &index, options.nr_decoders);
+    return;
+  }
+
+  if (options.pipeline)
+  {
+    ITCH::run_pipelined(message_reader, message_handler);
+    return;
+  }
+
+  auto block = std::make_unique<ITCH::MessageBlock>();
+
+  while (message_reader.next_block(*block))
+  {
+    message_handler.handle_block(*block);
+  }
+}
+
+// Runs as usual and snapshots the handler at every interval of market time, before its first message
+void build_time_index(ITCH::MessageReader &message_reader, ITCH::MessageHandler &message_handler,
+                      const Options &options)
+{
+  if (!message_reader.is_mapped())
+  {
+    throw "A time index needs an unzipped file!";
+  }
+
+  const auto        interval   = options.time_index_interval;
+  auto              time_index = ITCH::TimeIndex{message_reader.get_size()};
+  auto              message    = ITCH::Message{};
+  ITCH::Timestamp_t next_snapshot_time{};
+
+  while (message_reader.next(message))
+  {
+    const auto timestamp = message.get_timestamp();
+
+    if (timestamp >= next_snapshot_time)
+    {
+      const auto snapshot_time = (timestamp / interval) * interval;
+
+      if (next_snapshot_time)
+      {
+        const auto position = ITCH::SnapshotPosition{message.get_offset(), snapshot_time};
+        ITCH::save_snapshot(ITCH::TimeIndex::get_snapshot_path(options.filename, snapshot_time), message_handler,
+                            position);
+        time_index.add(position);
+      }
+
+      next_snapshot_time = snapshot_time + interval;
+    }
+
+    message_handler.handle_message(message);
+  }
+
+  time_index.save(options.filename);
+}
+
+// Replays the order book up to the start of the window, from the latest snapshot before it if there is a time index,
+// and reports the VWAP of the executions within the window
+void run_time_window(ITCH::MessageReader &message_reader, ITCH::MessageHandler &message_handler,
+                     const Options &options)
+{
+  auto  time_index = ITCH::TimeIndex{message_reader.get_size()};
+  auto *reader     = &message_reader;
+
+  std::unique_ptr<ITCH::MessageReader> resumed_reader;
+
+  if (message_reader.is_mapped() && time_index.load(options.filename))
+  {
+    if (const auto *position = time_index.find(options.start))
+    {
+      const auto path = ITCH::TimeIndex::get_snapshot_path(options.filename, position->timestamp);
+      ITCH::load_snapshot(path, message_handler);
+      resumed_reader =
+          std::make_unique<ITCH::MessageReader>(message_reader, position->offset, message_reader.get_size());
+      reader = resumed_reader.get();
+      std::cout << "Resumed from " << path << std::endl;
+    }
+  }
+
+  auto              message   = ITCH::Message{};
+  bool              in_window = false;
+  ITCH::Timestamp_t last_time{};
+
+  while (reader->next(message))
+  {
+    const auto decoded = ITCH::decode(message);
+    last_time          = decoded.timestamp;
+
+    if (decoded.timestamp < options.start)
+    {
+      message_handler.process(decoded);
+      continue;
+    }
+
+    if (!in_window)
+    {
+      // The window ends before the first message after its start
+      if (decoded.timestamp >= options.end)
+      {
+        break;
+      }
+
+      message_handler.start_window(options.start);
+      in_window = true;
+    }
+
+    if (decoded.timestamp >= options.end)
+    {
+      message_handler.close_window(options.end);
+      return;
+    }
+
+    message_handler.handle(decoded);
+  }
+
+  if (!in_window)
+  {
+    throw "No messages within the time window!";
+  }
+
+  // The input ran out before the end, the last reports cover up to the second after the last message
+  message_handler.close_window(
+      std::min(options.end, (last_time / ITCH::SEC_IN_NANOS + 1) * ITCH::SEC_IN_NANOS));
+}
+
+// Runs as usual from the newest checkpoint if there is one, checkpointing periodically
+void run_with_checkpoints(ITCH::MessageReader &message_reader, ITCH::MessageHandler &message_handler,
+                          const Options &options)
+{
+  auto  checkpointer = ITCH::Checkpointer{options.filename, options.checkpoint_interval};
+  auto *reader       = &message_reader;
+  auto  message      = ITCH::Message{};
+
+  std::unique_ptr<ITCH::MessageReader> resumed_reader;
+
+  if (const auto position = checkpointer.restore(message_handler))
+  {
+    std::cout << "Resumed from " << ITCH::Checkpointer::get_path(options.filename) << std::endl;
+
+    if (message_reader.is_mapped())
+    {
+      if (position->offset > message_reader.get_size())
+      {
+        throw "Checkpoint does not match the file!";
+      }
+
+      resumed_reader =
+          std::make_unique<ITCH::MessageReader>(message_reader, position->offset, message_reader.get_size());
+      reader = resumed_reader.get();
+    }
+    else
+    {
+      // A stream can't seek, skip the decompressed messages contained in the checkpoint
+      while (message_reader.next(message) && (message.get_offset() < position->offset))
+      {
+      }
+
+      if (message.get_offset() == position->offset)
+      {
+        checkpointer.on_message(message, message_handler);
+        message_handler.handle_message(message);
+      }
+    }
+  }
+
+  while (reader->next(message))
+  {
+    checkpointer.on_message(message, message_handler);
+    message_handler.handle_message(message);
+  }
+
+  checkpointer.finish();
+}
+
+template <typename Handler>
+void instrument(Handler &message_handler, const Options &options, ITCH::PerfProfile *perf_profile,
+                ITCH::ProgressCounters *progress)
+{
+  if (options.stats)
+  {
+    message_handler.enable_stats();
+  }
+
+  if constexpr (requires { message_handler.set_perf_profile(perf_profile); })
+  {
+    message_handler.set_perf_profile(perf_profile);
+  }
+
+  if (progress)
+  {
+    message_handler.set_progress(progress);
+  }
+}
+
+// Adds the last progress counts, the sharded handler only once finished, and prints the stats
+template <typename Handler> void finish_instruments(Handler &message_handler)
+{
+  message_handler.flush_progress();
+
+  if (const auto *stats = message_handler.get_stats())
+  {
+    stats->print(std::cout);
+  }
+}
 
 int main(int argc, char *argv[])
 {
-  if (argc < 2)
+  auto options = Options{};
+
+  if (!parse_options(argc, argv, options))
   {
-    std::cout << "Usage:" << std::endl
-              << "\tITCH50_Hourly_VWAP <unzipped NASDAQ ITCH 5.0 file>" << std::endl
-              << "\tExample: ITCH50_Hourly_VWAP 01302019.NASDAQ_ITCH50" << std::endl;
+    print_usage();
+    return -1;
   }
 
   std::ios::sync_with_stdio(false);
 
   try
   {
-    const auto filename{argv[1]};
-    auto       message         = ITCH::Message{};
-    auto       message_reader  = ITCH::MessageReader{filename};
-    auto       message_handler = ITCH::MessageHandler{};
+    // Counts from before the file is opened, on this thread only
+    std::unique_ptr<ITCH::PerfProfile> perf_profile;
 
-    while (message_reader.next(message))
+    if (options.perf)
     {
-      message_handler.handle_message(message);
+      perf_profile = std::make_unique<ITCH::PerfProfile>();
+
+      if (!perf_profile->is_open())
+      {
+        std::cerr << "No perf counters available, check /proc/sys/kernel/perf_event_paranoid" << std::endl;
+      }
+    }
+
+    // Read by a sidecar thread, which stops and prints the totals before the counters go away
+    std::unique_ptr<ITCH::ProgressCounters> progress;
+    std::unique_ptr<ITCH::ProgressReporter> progress_reporter;
+
+    if (options.progress_interval.count())
+    {
+      progress          = std::make_unique<ITCH::ProgressCounters>();
+      progress_reporter = std::make_unique<ITCH::ProgressReporter>(*progress, std::cerr, options.progress_interval);
     }
+
+    // The stats count every message type of the day, including the ones the handler ignores
+    auto message_reader = ITCH::MessageReader{options.filename};
+    message_reader.set_type_filter(options.stats ? ITCH::ALL_MESSAGE_TYPES : ITCH::MessageHandler::TYPE_FILTER);
+    message_reader.set_progress(progress.get());
+
+    if (perf_profile)
+    {
+      perf_profile->set_phase(ITCH::PerfProfile::Parsing);
+    }
+
+    if (options.build_index)
+    {
+      const auto index = ITCH::MessageIndex::build(message_reader);
+      index.save(options.filename);
+      std::cout << "Indexed " << index.get_nr_chunks() << " chunks" << std::endl;
+    }
+    else if (options.nr_shards)
+    {
+      auto message_handler = ITCH::ShardedMessageHandler{options.nr_shards, options.report};
+      instrument(message_handler, options, perf_profile.get(), progress.get());
+      run(message_reader, message_handler, options);
+      message_handler.finish();
+      finish_instruments(message_handler);
+    }
+    else if (options.time_index_interval)
+    {
+      auto message_handler = ITCH::MessageHandler{ITCH::INITIAL_NR_ORDERS, options.report};
+      instrument(message_handler, options, perf_profile.get(), progress.get());
+      build_time_index(message_reader, message_handler, options);
+      finish_instruments(message_handler);
+    }
+    else if (options.checkpoint_interval)
+    {
+      auto message_handler = ITCH::MessageHandler{ITCH::INITIAL_NR_ORDERS, options.report};
+      instrument(message_handler, options, perf_profile.get(), progress.get());
+      run_with_checkpoints(message_reader, message_handler, options);
+      finish_instruments(message_handler);
+    }
+    else if (is_time_window(options))
+    {
+      auto message_handler = ITCH::MessageHandler{ITCH::INITIAL_NR_ORDERS, options.report};
+      instrument(message_handler, options, perf_profile.get(), progress.get());
+      run_time_window(message_reader, message_handler, options);
+      finish_instruments(message_handler);
+    }
+    else
+    {
+      auto message_handler = ITCH::MessageHandler{ITCH::INITIAL_NR_ORDERS, options.report};
+      instrument(message_handler, options, perf_profile.get(), progress.get());
+      run(message_reader, message_handler, options);
+      finish_instruments(message_handler);
+    }
+
+    message_reader.flush_progress();
+    progress_reporter.reset();
+
+    if (perf_profile)
+    {
+      perf_profile->print(std::cout);
+    }
+  }
+  catch (const char *error)
+  {
+    std::cerr << "An error occurred: " << error << std::endl;
+    return -1;
   }
   catch (const std::exception &ex)
   {